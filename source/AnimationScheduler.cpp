@@ -0,0 +1,127 @@
+/* AnimationScheduler.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "AnimationScheduler.h"
+
+#include <QEvent>
+#include <QScreen>
+#include <QWidget>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+    // After a long stall, skip ahead rather than trying to catch up.
+    const int MAX_STEPS = 4;
+}
+
+
+
+// Call the given slot of the widget on every tick.
+AnimationScheduler::AnimationScheduler(QWidget *widget, const char *slot, double stepsPerSecond)
+    : QObject(widget), widget(widget), stepsPerSecond(stepsPerSecond)
+{
+    connect(&timer, SIGNAL(timeout()), widget, slot);
+    widget->installEventFilter(this);
+    Update();
+}
+
+
+
+void AnimationScheduler::SetPaused(bool isPaused)
+{
+    this->isPaused = isPaused;
+    Update();
+}
+
+
+
+bool AnimationScheduler::IsPaused() const
+{
+    return isPaused;
+}
+
+
+
+// Set whether there is anything that moves.
+void AnimationScheduler::SetActive(bool isActive)
+{
+    this->isActive = isActive;
+    Update();
+}
+
+
+
+// Get the number of steps to advance by since the last tick.
+int AnimationScheduler::Steps()
+{
+    if(!clock.isValid())
+    {
+        clock.start();
+        return 1;
+    }
+    elapsedSteps += clock.restart() * .001 * stepsPerSecond;
+    int steps = elapsedSteps;
+    elapsedSteps -= steps;
+    return min(steps, MAX_STEPS);
+}
+
+
+
+bool AnimationScheduler::eventFilter(QObject *object, QEvent *event)
+{
+    if(object == widget && (event->type() == QEvent::Show || event->type() == QEvent::Hide))
+    {
+        // Minimizing does not hide the widget itself, so watch its window too.
+        // The window is not known until the widget has been added to it.
+        if(widget->window() != window)
+        {
+            if(window)
+                window->removeEventFilter(this);
+            window = widget->window();
+            if(window != widget)
+                window->installEventFilter(this);
+        }
+        Update();
+    }
+    else if(object == window && event->type() == QEvent::WindowStateChange)
+        Update();
+    return false;
+}
+
+
+
+// Start or stop the timer to match the widget's current state.
+void AnimationScheduler::Update()
+{
+    if(isPaused || !isActive || !widget->isVisible() || widget->window()->isMinimized())
+    {
+        timer.stop();
+        return;
+    }
+
+    // Ticking faster than the steps would just draw the same frame again.
+    double rate = stepsPerSecond;
+    if(widget->screen() && widget->screen()->refreshRate() > 0.)
+        rate = min(rate, widget->screen()->refreshRate());
+    int interval = max(1, static_cast<int>(round(1000. / rate)));
+    if(!timer.isActive())
+    {
+        clock.start();
+        elapsedSteps = 0.;
+        timer.start(interval);
+    }
+    else if(timer.interval() != interval)
+        timer.setInterval(interval);
+}
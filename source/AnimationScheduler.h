@@ -0,0 +1,70 @@
+/* AnimationScheduler.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef ANIMATIONSCHEDULER_H
+#define ANIMATIONSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+class QEvent;
+class QWidget;
+
+
+
+// Class for driving a widget's animation timer only while there is something
+// to see. The timer is stopped whenever the widget is hidden (e.g. because
+// another tab is selected), its window is minimized, the animation is paused,
+// or there is nothing moving. While it runs, it ticks at the display's refresh
+// rate, but never faster than the animation's own step rate; Steps() then says
+// how many steps to advance, so the speed of the animation does not depend on
+// how often it is drawn.
+class AnimationScheduler : public QObject {
+public:
+    // Call the given slot of the widget on every tick.
+    AnimationScheduler(QWidget *widget, const char *slot, double stepsPerSecond = 60.);
+
+    void SetPaused(bool isPaused);
+    bool IsPaused() const;
+    // Set whether there is anything that moves.
+    void SetActive(bool isActive);
+
+    // Get the number of steps to advance by since the last tick.
+    int Steps();
+
+
+protected:
+    virtual bool eventFilter(QObject *object, QEvent *event) override;
+
+
+private:
+    // Start or stop the timer to match the widget's current state.
+    void Update();
+
+
+private:
+    QWidget *widget;
+    QWidget *window = nullptr;
+    double stepsPerSecond;
+
+    QTimer timer;
+    QElapsedTimer clock;
+    double elapsedSteps = 0.;
+
+    bool isPaused = false;
+    bool isActive = true;
+};
+
+
+
+#endif // ANIMATIONSCHEDULER_H
@@ -12,77 +12,368 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "AsteroidField.h"
 
+#include "Random.h"
 #include "SpriteSet.h"
 #include "System.h"
 
+#include <QHash>
+#include <QImage>
 #include <QPainter>
-#include <QString>
+#include <QPixmap>
+#include <QRectF>
+#include <QSize>
 
+#include <algorithm>
 #include <cmath>
+#include <map>
 
 using namespace std;
 
+namespace {
+    // The asteroids wrap around in a square this size, centered on the origin.
+    const float WRAP = 4096.f;
+    const float HALF_WRAP = .5f * WRAP;
+    // Spin rates are stored in fractions of a frame per step.
+    const int SUBFRAMES = 16;
+    const int MAX_SPIN = 8;
+    // Stop looking for more spin frames after this many.
+    const int MAX_FRAMES = 100;
+
+    // Minables are sorted into a grid of square bins this size, which covers
+    // every orbit around a belt of up to this radius.
+    const float BIN_SIZE = 512.f;
+    const float BIN_EXTENT = 4096.f;
+    const int BIN_COLUMNS = 2. * BIN_EXTENT / BIN_SIZE;
+    // Systems with minables but no belt use the game's default radius.
+    const double DEFAULT_BELT = 1500.;
+    // Minables' orbits are at most this eccentric, and their sizes vary by
+    // this fraction around the belt radius.
+    const double MAX_ECCENTRICITY = .3;
+    const double BELT_SPREAD = .2;
+    // Converts a minable's energy to its angular momentum. At this scale, a
+    // minable with an energy of 1 moves about 1 unit per step on a belt with
+    // a radius of 1500.
+    const double MOMENTUM = 40.;
+    const float TWO_PI = 6.2831853f;
+
+    int BinIndex(float value)
+    {
+        return max(0, min(BIN_COLUMNS - 1, static_cast<int>(floor((value + BIN_EXTENT) / BIN_SIZE))));
+    }
+
+    // Move each coordinate by its velocity, wrapping it back into the square.
+    // No asteroid moves more than half the size of the square in one step, so
+    // the shifted value below is always positive and truncating it finds how
+    // many squares (-1, 0, or 1) the asteroid is outside of this one. This has
+    // no branches or comparisons, which keeps the loop vectorizable even when
+    // floating point comparisons are allowed to trap.
+    void Advance(float *position, const float *velocity, size_t count)
+    {
+        for(size_t i = 0; i < count; ++i)
+        {
+            float value = position[i] + velocity[i];
+            int squares = static_cast<int>((value + (HALF_WRAP + WRAP)) * (1.f / WRAP)) - 1;
+            position[i] = value - WRAP * squares;
+        }
+    }
+}
+
+
+
+// All the spin frames of one type of asteroid, scaled to the size they are
+// drawn at and laid out in a grid in a single image.
+class AsteroidField::Atlas {
+public:
+    // Get the part of the image holding the given frame.
+    QRectF Frame(int index) const;
+
+public:
+    QPixmap image;
+    int frames = 0;
+    int columns = 1;
+    QSize frameSize;
+};
+
+
+
+QRectF AsteroidField::Atlas::Frame(int index) const
+{
+    return QRectF((index % columns) * frameSize.width(), (index / columns) * frameSize.height(),
+        frameSize.width(), frameSize.height());
+}
+
 
 
 void AsteroidField::Set(const System *system)
 {
-    asteroids.clear();
+    x.clear();
+    y.clear();
+    velocityX.clear();
+    velocityY.clear();
+    type.clear();
+    phase.clear();
+    spin.clear();
+    atlases.clear();
+    steps = 0;
+    minables = 0;
+    scale.clear();
+    eccentricity.clear();
+    rotation.clear();
+    theta.clear();
+    momentum.clear();
+    binned.clear();
+    binStart.clear();
     if(!system)
         return;
 
+    // The asteroids are only scenery, but the same system should look the
+    // same each time it is viewed.
+    Random random(qHash(system->TrueName()));
     for(const System::Asteroid &it : system->Asteroids())
     {
-        QPixmap sprite = SpriteSet::Get("asteroid/" + it.type + "/spin-00");
+        uint16_t index = atlases.size();
+        atlases.push_back(GetAtlas(it.type));
+        for(int i = 0; i < it.count; ++i)
+        {
+            double angle = random.Int(6283) * .001;
+            double velocity = random.Int(1000) * (.001 * it.energy);
+            float startX = random.Int(4096) - 2048;
+            float startY = random.Int(4096) - 2048;
+            Add(startX, startY, index, atlases.back()->frames, random);
+            velocityX.push_back(velocity * sin(angle));
+            velocityY.push_back(velocity * cos(angle));
+        }
+    }
+
+    // Each minable picks one of the belts, with the given weights.
+    minables = x.size();
+    int totalWeight = 0;
+    for(const System::Belt &belt : system->Belts())
+        totalWeight += max(0, belt.weight);
+    for(const System::Minable &it : system->Minables())
+    {
+        uint16_t index = atlases.size();
+        atlases.push_back(GetAtlas(it.type));
         for(int i = 0; i < it.count; ++i)
         {
-            double angle = (rand() % 6283) * .001;
-            double velocity = (rand() % 1000) * (.001 * it.energy);
-            asteroids.push_back({
-                QVector2D(rand() % 4096 - 2048, rand() % 4096 - 2048),
-                QVector2D(velocity * sin(angle), velocity * cos(angle)),
-                sprite});
+            double belt = DEFAULT_BELT;
+            int choice = random.Int(totalWeight);
+            for(const System::Belt &option : system->Belts())
+            {
+                belt = option.radius;
+                choice -= max(0, option.weight);
+                if(choice < 0)
+                    break;
+            }
+
+            // The orbit's semi-major axis is near the belt radius. Its scale
+            // is the radius at right angles to the axis.
+            double axis = belt * (1. + BELT_SPREAD * (2. * random.Real() - 1.));
+            double e = MAX_ECCENTRICITY * random.Real();
+            double orbitScale = axis * (1. - e * e);
+            scale.push_back(orbitScale);
+            eccentricity.push_back(e);
+            rotation.push_back(TWO_PI * random.Real());
+            theta.push_back(TWO_PI * random.Real());
+            momentum.push_back(MOMENTUM * it.energy * sqrt(orbitScale));
+            Add(0.f, 0.f, index, atlases.back()->frames, random);
         }
     }
+    Orbit();
+    Bin();
 }
 
 
 
 void AsteroidField::Step()
 {
-    for(Asteroid &asteroid : asteroids)
-    {
-        asteroid.position += asteroid.velocity;
-        if(asteroid.position.x() < -2048.)
-            asteroid.position += QVector2D(4096., 0.);
-        if(asteroid.position.x() >= 2048.)
-            asteroid.position -= QVector2D(4096., 0.);
-        if(asteroid.position.y() < -2048.)
-            asteroid.position += QVector2D(0., 4096.);
-        if(asteroid.position.y() >= 2048.)
-            asteroid.position -= QVector2D(0., 4096.);
-    }
+    Advance(x.data(), velocityX.data(), minables);
+    Advance(y.data(), velocityY.data(), minables);
+    Orbit();
+    Bin();
+    ++steps;
 }
 
 
 
-void AsteroidField::Draw(QPainter &painter, const QRectF &bounds) const
+// Draw the asteroids within the given bounds, and return how many sprites
+// were drawn.
+int AsteroidField::Draw(QPainter &painter, const QRectF &bounds) const
 {
-    int firstX = round(bounds.left() / 4096.);
-    int lastX = round(bounds.right() / 4096.);
-    int firstY = round(bounds.top() / 4096.);
-    int lastY = round(bounds.bottom() / 4096.);
-    for(int y = firstY; y <= lastY; ++y)
-        for(int x = firstX; x <= lastX; ++x)
+    // Gather the visible asteroids of each type into one batch, so that each
+    // atlas is only drawn from with a single call.
+    vector<vector<QPainter::PixmapFragment>> batches(atlases.size());
+    int firstX = round(bounds.left() / WRAP);
+    int lastX = round(bounds.right() / WRAP);
+    int firstY = round(bounds.top() / WRAP);
+    int lastY = round(bounds.bottom() / WRAP);
+    for(int tileY = firstY; tileY <= lastY; ++tileY)
+        for(int tileX = firstX; tileX <= lastX; ++tileX)
+            for(unsigned i = 0; i < minables; ++i)
+                Gather(i, tileX * WRAP, tileY * WRAP, bounds, batches);
+
+    // Minables do not repeat, and only the bins the view overlaps need to be
+    // checked. A minable is drawn down and to the right of its position, so
+    // also check the bins that far up and to the left of the view.
+    if(!binStart.empty())
+    {
+        int margin = 0;
+        for(const Atlas *atlas : atlases)
+            margin = max(margin, max(atlas->frameSize.width(), atlas->frameSize.height()));
+        int left = BinIndex(bounds.left() - margin);
+        int right = BinIndex(bounds.right());
+        int top = BinIndex(bounds.top() - margin);
+        int bottom = BinIndex(bounds.bottom());
+        for(int row = top; row <= bottom; ++row)
         {
-            QVector2D offset(x * 4096., y * 4096.);
-            for(const Asteroid &asteroid : asteroids)
-            {
-                QPointF thisOffset = (asteroid.position + offset).toPointF();
-                painter.translate(thisOffset);
-                painter.scale(.5, .5);
-                painter.drawPixmap(QPointF(), asteroid.sprite);
-                painter.scale(2., 2.);
-                painter.translate(-thisOffset);
-            }
+            // The bins in one row are next to each other in the sorted list.
+            unsigned first = binStart[row * BIN_COLUMNS + left];
+            unsigned last = binStart[row * BIN_COLUMNS + right + 1];
+            for(unsigned i = first; i < last; ++i)
+                Gather(binned[i], 0.f, 0.f, bounds, batches);
+        }
+    }
+
+    int drawn = 0;
+    for(unsigned i = 0; i < batches.size(); ++i)
+        if(!batches[i].empty())
+        {
+            painter.drawPixmapFragments(batches[i].data(), batches[i].size(), atlases[i]->image);
+            drawn += batches[i].size();
         }
+    return drawn;
+}
+
+
+
+bool AsteroidField::IsEmpty() const
+{
+    return x.empty();
+}
+
+
+
+// Get the atlas for the given type of asteroid, loading it if necessary.
+const AsteroidField::Atlas *AsteroidField::GetAtlas(const QString &type)
+{
+    // The same type may have different sprites in a map loaded from elsewhere.
+    static map<QString, Atlas> loaded;
+    QString key = SpriteSet::RootPath() + type;
+    auto it = loaded.find(key);
+    if(it != loaded.end())
+        return &it->second;
+
+    Atlas &atlas = loaded[key];
+    vector<QImage> frames;
+    for(int i = 0; i < MAX_FRAMES; ++i)
+    {
+        QImage frame = SpriteSet::Load("asteroid/" + type + QString("/spin-%1").arg(i, 2, 10, QChar('0')));
+        if(frame.isNull())
+            break;
+        frames.push_back(frame);
+    }
+    if(frames.empty())
+        return &atlas;
+
+    // Asteroids are drawn at half size, so scale the frames once here rather
+    // than transforming the painter for every asteroid. Lay them out in a
+    // roughly square grid, to keep the image within texture size limits.
+    atlas.frames = frames.size();
+    atlas.columns = ceil(sqrt(atlas.frames));
+    int rows = (atlas.frames + atlas.columns - 1) / atlas.columns;
+    atlas.frameSize = QSize(max(1, frames.front().width() / 2), max(1, frames.front().height() / 2));
+    QImage image(atlas.columns * atlas.frameSize.width(), rows * atlas.frameSize.height(),
+        QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    {
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        for(int i = 0; i < atlas.frames; ++i)
+            painter.drawImage(atlas.Frame(i), frames[i]);
+    }
+    atlas.image = QPixmap::fromImage(image);
+    return &atlas;
+}
+
+
+
+// Add an asteroid of the given type to the end of the arrays.
+void AsteroidField::Add(float x, float y, uint16_t type, int frames, Random &random)
+{
+    this->x.push_back(x);
+    this->y.push_back(y);
+    this->type.push_back(type);
+    phase.push_back(random.Int(min(max(1, frames), 256)));
+    spin.push_back(random.Int(2 * MAX_SPIN + 1) - MAX_SPIN);
+}
+
+
+
+// Move the minables along their orbits. Each one's distance from the star is
+// given by the equation of its ellipse, and the angle it moves by in each step
+// is its angular momentum divided by that distance squared, so it speeds up
+// near the star, as it would under gravity.
+void AsteroidField::Orbit()
+{
+    for(unsigned i = 0; i < scale.size(); ++i)
+    {
+        float radius = scale[i] / (1.f + eccentricity[i] * cos(theta[i]));
+        theta[i] += momentum[i] / (radius * radius);
+        if(theta[i] >= TWO_PI)
+            theta[i] -= TWO_PI;
+
+        radius = scale[i] / (1.f + eccentricity[i] * cos(theta[i]));
+        float angle = theta[i] + rotation[i];
+        x[minables + i] = radius * cos(angle);
+        y[minables + i] = radius * sin(angle);
+    }
+}
+
+
+
+// Sort the minables into bins, by counting how many are in each bin and then
+// placing each one after the ones in all the bins before it.
+void AsteroidField::Bin()
+{
+    if(scale.empty())
+        return;
+
+    binStart.assign(BIN_COLUMNS * BIN_COLUMNS + 1, 0);
+    for(unsigned i = minables; i < x.size(); ++i)
+        ++binStart[BinIndex(y[i]) * BIN_COLUMNS + BinIndex(x[i]) + 1];
+    for(unsigned i = 1; i < binStart.size(); ++i)
+        binStart[i] += binStart[i - 1];
+
+    vector<unsigned> next(binStart.begin(), binStart.end() - 1);
+    binned.resize(scale.size());
+    for(unsigned i = minables; i < x.size(); ++i)
+        binned[next[BinIndex(y[i]) * BIN_COLUMNS + BinIndex(x[i])]++] = i;
+}
+
+
+
+// If the given asteroid, moved by the given offset, is within the bounds,
+// add it to the batch for its type.
+void AsteroidField::Gather(unsigned i, float offsetX, float offsetY, const QRectF &bounds,
+    vector<vector<QPainter::PixmapFragment>> &batches) const
+{
+    const Atlas &atlas = *atlases[type[i]];
+    int width = atlas.frameSize.width();
+    int height = atlas.frameSize.height();
+    float left = x[i] + offsetX;
+    float top = y[i] + offsetY;
+    if(!atlas.frames || left > bounds.right() || top > bounds.bottom()
+            || left + width < bounds.left() || top + height < bounds.top())
+        return;
+
+    // Find which frame this asteroid has spun to.
+    int64_t position = phase[i] * SUBFRAMES + static_cast<int64_t>(steps) * spin[i];
+    int frame = (position / SUBFRAMES) % atlas.frames;
+    if(frame < 0)
+        frame += atlas.frames;
+
+    // Fragments are positioned by their centers, but each asteroid's position
+    // is the corner of its sprite.
+    QPointF center(left + .5 * width, top + .5 * height);
+    batches[type[i]].push_back(QPainter::PixmapFragment::create(center, atlas.Frame(frame)));
 }
@@ -13,37 +13,89 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef ASTEROIDFIELD_H
 #define ASTEROIDFIELD_H
 
-#include <QPixmap>
+#include <QPainter>
 #include <QString>
-#include <QVector2D>
 
-#include <list>
+#include <cstdint>
+#include <vector>
 
+class Random;
 class System;
 
-class QPainter;
 class QRectF;
 
 
 
+// Class for animating the asteroids of the system being viewed. They drift in a
+// 4096 by 4096 square, wrapping around at the edges, which is tiled to cover
+// the view. The asteroids are stored as separate arrays of each coordinate
+// rather than as objects, so that Step() is a simple loop the compiler can
+// vectorize; each asteroid refers to its sprite by index. They are drawn with
+// one batch of fragments per sprite, rather than one draw call per asteroid.
+// All the spin frames of each type of asteroid are packed into one shared atlas
+// image, and each asteroid just has a starting frame and a spin rate. Minable
+// asteroids are kept in the same arrays, after the ordinary ones, but instead
+// of drifting they orbit the star on ellipses around the system's belts. They
+// are sorted into a grid of bins after each step, so that drawing them only
+// has to look at the bins that are in view.
 class AsteroidField {
 public:
     void Set(const System *system);
     void Step();
-    void Draw(QPainter &painter, const QRectF &bounds) const;
+    // Draw the asteroids within the given bounds, and return how many sprites
+    // were drawn.
+    int Draw(QPainter &painter, const QRectF &bounds) const;
+
+    bool IsEmpty() const;
 
 
 private:
-    class Asteroid {
-    public:
-        QVector2D position;
-        QVector2D velocity;
-        QPixmap sprite;
-    };
+    class Atlas;
+
+    // Get the atlas for the given type of asteroid, loading it if necessary.
+    static const Atlas *GetAtlas(const QString &type);
+    // Add an asteroid of the given type to the end of the arrays.
+    void Add(float x, float y, uint16_t type, int frames, Random &random);
+    // Move the minables along their orbits, and sort them into bins.
+    void Orbit();
+    void Bin();
+    // If the given asteroid, moved by the given offset, is within the bounds,
+    // add it to the batch for its type.
+    void Gather(unsigned i, float offsetX, float offsetY, const QRectF &bounds,
+        std::vector<std::vector<QPainter::PixmapFragment>> &batches) const;
 
 
 private:
-    std::list<Asteroid> asteroids;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<uint16_t> type;
+    // The frame each asteroid starts on, and how fast it spins through its
+    // frames (in sixteenths of a frame per step, negative to spin backwards).
+    std::vector<uint8_t> phase;
+    std::vector<int8_t> spin;
+    unsigned steps = 0;
+
+    // The minables start at this index. Each one's orbit is an ellipse with
+    // the star at one focus, given by its size and shape, the angle of its
+    // axis, and how far around the ellipse the minable is.
+    unsigned minables = 0;
+    std::vector<float> scale;
+    std::vector<float> eccentricity;
+    std::vector<float> rotation;
+    std::vector<float> theta;
+    std::vector<float> momentum;
+
+    // The indices of the minables, in order of which bin they are in, and the
+    // index in that list where each bin starts. The bins cover a square grid
+    // centered on the star, and minables outside of it go in the nearest bin.
+    std::vector<unsigned> binned;
+    std::vector<unsigned> binStart;
+
+    // The atlas for each type of asteroid. These are shared by all fields,
+    // and are never freed.
+    std::vector<const Atlas *> atlases;
 };
 
 
@@ -0,0 +1,791 @@
+/* BatchMode.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "BatchMode.h"
+
+#include "AsteroidField.h"
+#include "DataFile.h"
+#include "DataWriter.h"
+#include "GalaxyRenderer.h"
+#include "Map.h"
+#include "MapChecker.h"
+#include "MapDiff.h"
+#include "MapQuery.h"
+#include "OrbitPropagator.h"
+#include "ParallelFor.h"
+#include "Planet.h"
+#include "Random.h"
+#include "RegionGenerator.h"
+#include "SpriteSet.h"
+#include "StellarObject.h"
+#include "System.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QImage>
+#include <QPixmap>
+#include <QPolygonF>
+#include <QRectF>
+#include <QVector2D>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <set>
+#include <utility>
+
+using namespace std;
+
+namespace {
+    const char *COMMANDS[] = {"validate", "format", "stats", "query", "diff", "merge", "render", "benchmark"};
+    const char *BENCHMARKS[] = {"asteroids", "orbits", "region", "merge"};
+
+    // What processing one file printed, and its exit status.
+    struct Output {
+        QString out;
+        QString err;
+        int status = BatchMode::SUCCESS;
+    };
+
+    // Process the files on the worker threads, then print what each one
+    // produced in the order they were given, and return the worst status.
+    // The function is given the index of each file, and its output.
+    template <class Function>
+    int ForEachFile(const vector<QString> &paths, Function function)
+    {
+        vector<Output> outputs(paths.size());
+        ParallelFor(paths.size(), [&](int i)
+        {
+            function(i, outputs[i]);
+        });
+
+        int status = BatchMode::SUCCESS;
+        for(const Output &output : outputs)
+        {
+            cout << output.out.toStdString();
+            cerr << output.err.toStdString();
+            status = max(status, output.status);
+        }
+        cout.flush();
+        return status;
+    }
+
+    // Map::Load() and DataFile::Load() just leave the data empty if the file
+    // is missing, so check that first.
+    bool IsReadable(const QString &path, Output &output)
+    {
+        QFileInfo info(path);
+        if(info.isFile() && info.isReadable())
+            return true;
+
+        output.err += "Unable to read \"" + path + "\".\n";
+        output.status = BatchMode::FILE_ERROR;
+        return false;
+    }
+
+    // Load the given map, or report that it cannot be read.
+    bool LoadMap(const QString &path, Map &mapData, Output &output)
+    {
+        if(!IsReadable(path, output))
+            return false;
+        mapData.Load(path);
+        return true;
+    }
+
+    // Load the given data files all at once. If any cannot be read, report it
+    // and return the exit status.
+    int LoadFiles(const vector<QString> &paths, vector<DataFile> &files)
+    {
+        files.resize(paths.size());
+        return ForEachFile(paths, [&paths, &files](int i, Output &output)
+        {
+            if(IsReadable(paths[i], output))
+                files[i].Load(paths[i]);
+        });
+    }
+
+    // Write the given data to a file, or report that it cannot be written.
+    int WriteFile(const QString &path, const QByteArray &data)
+    {
+        QFile file(path);
+        if(file.open(QFile::WriteOnly) && file.write(data) == data.size())
+            return BatchMode::SUCCESS;
+
+        cerr << "Unable to write \"" << path.toStdString() << "\"." << endl;
+        return BatchMode::FILE_ERROR;
+    }
+
+    int Usage(const QString &message)
+    {
+        cerr << message.toStdString() << endl;
+        cerr << "Run with --help to see the available commands." << endl;
+        return BatchMode::USAGE;
+    }
+
+    // Run the given step until at least the given number of runs and half a
+    // second have gone by, and print the average time per run.
+    void Time(const QString &description, int runs, const function<void()> &step)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        int count = 0;
+        while(count < runs || timer.elapsed() < 500)
+        {
+            step();
+            ++count;
+        }
+        double micros = timer.nsecsElapsed() * .001 / count;
+        cout << description.toStdString() << ": " << micros << " us per run (" << count << " runs)" << endl;
+    }
+
+    // The asteroid field's step as it was before the asteroids were stored as
+    // arrays: a list of asteroids that each have their own copy of their
+    // sprite, wrapped around the square with branches. It is only kept so that
+    // the benchmark has something to compare the current step against.
+    struct ListAsteroid {
+        QVector2D position;
+        QVector2D velocity;
+        QPixmap sprite;
+    };
+
+    void StepList(list<ListAsteroid> &asteroids)
+    {
+        for(ListAsteroid &asteroid : asteroids)
+        {
+            asteroid.position += asteroid.velocity;
+            if(asteroid.position.x() < -2048.)
+                asteroid.position += QVector2D(4096., 0.);
+            if(asteroid.position.x() >= 2048.)
+                asteroid.position -= QVector2D(4096., 0.);
+            if(asteroid.position.y() < -2048.)
+                asteroid.position += QVector2D(0., 4096.);
+            if(asteroid.position.y() >= 2048.)
+                asteroid.position -= QVector2D(0., 4096.);
+        }
+    }
+
+    // Step an asteroid field that has the given number of drifting asteroids,
+    // and then the same number of asteroids with the old list-based step.
+    void BenchmarkAsteroids(int count)
+    {
+        DataFile file;
+        file.LoadText("system Benchmark\n\tasteroids \"small rock\" " + QString::number(count) + " 3\n");
+        System system;
+        system.Load(*file.begin());
+        AsteroidField field;
+        field.Set(&system);
+        Time("asteroids: step " + QString::number(count) + " asteroids", 100, [&field]()
+        {
+            field.Step();
+        });
+
+        list<ListAsteroid> asteroids;
+        QPixmap sprite = SpriteSet::Get("asteroid/small rock/spin-00");
+        Random random(1);
+        for(int i = 0; i < count; ++i)
+        {
+            double angle = random.Int(6283) * .001;
+            double velocity = random.Int(1000) * .003;
+            asteroids.push_back({
+                QVector2D(random.Int(4096) - 2048, random.Int(4096) - 2048),
+                QVector2D(velocity * sin(angle), velocity * cos(angle)),
+                sprite});
+        }
+        Time("asteroids: step " + QString::number(count) + " asteroids in a list (old step)", 100, [&asteroids]()
+        {
+            StepList(asteroids);
+        });
+    }
+
+    // Propagate randomly generated systems with at least the given number of
+    // stellar objects in total, all in one batch, and then one at a time.
+    void BenchmarkOrbits(int count)
+    {
+        vector<System> systems;
+        int objects = 0;
+        for(int i = 0; objects < count; ++i)
+        {
+            Random random(1, i);
+            systems.emplace_back();
+            systems.back().Init("Benchmark " + QString::number(i), QVector2D(), random);
+            objects += systems.back().Objects().size();
+        }
+
+        OrbitPropagator propagator;
+        for(const System &system : systems)
+            propagator.Add(system);
+        double day = 0.;
+        Time("orbits: propagate " + QString::number(objects) + " objects in one batch", 10, [&]()
+        {
+            propagator.Propagate(day += 1.);
+        });
+        Time("orbits: System::SetDay() on " + QString::number(systems.size()) + " systems", 10, [&]()
+        {
+            day += 1.;
+            for(System &system : systems)
+                system.SetDay(day);
+        });
+    }
+
+    // Fill an empty region with the given number of new systems.
+    void BenchmarkRegion(int count)
+    {
+        Map mapData;
+        QPolygonF region(QRectF(-2000., -2000., 4000., 4000.));
+        size_t generated = 0;
+        Time("region: generate " + QString::number(count) + " systems", 1, [&]()
+        {
+            generated = RegionGenerator(region, 1).Generate(mapData, count, "Benchmark").size();
+        });
+        if(generated < static_cast<size_t>(count))
+            cout << "region: only " << generated << " systems fit." << endl;
+    }
+
+    // Diff and merge copies of a generated map with the given number of
+    // systems, each with a government, prices for every standard commodity,
+    // and a planet with a description. "Ours" moves one system in fifty, and
+    // "theirs" changes a price in a different one in fifty, so the merge has
+    // no conflicts. The files are parsed each time, since that is where the
+    // hashes that let identical entities be skipped are computed.
+    void BenchmarkMerge(int count)
+    {
+        static const char *COMMODITIES[] = {"Food", "Clothing", "Metal", "Plastic", "Equipment",
+            "Medical", "Industrial", "Electronics", "Heavy Metals", "Luxury Goods"};
+
+        Map mapData;
+        QPolygonF region(QRectF(-2000., -2000., 4000., 4000.));
+        for(System &system : RegionGenerator(region, 1).Generate(mapData, count, "Benchmark"))
+        {
+            system.SetGovernment("Republic");
+            for(const char *commodity : COMMODITIES)
+                system.SetTrade(commodity, 500);
+            for(StellarObject &object : system.Objects())
+                if(!object.IsStar())
+                {
+                    QString name = system.TrueName() + " Prime";
+                    mapData.RenamePlanet(&object, name);
+                    mapData.Planets()[name].SetDescription("The first settlers of " + name
+                        + " found a world that was habitable, if not welcoming. Its towns are"
+                        " spread along the coasts, and most of its people work in the orbital"
+                        " shipyards or on the farms that supply them.");
+                    break;
+                }
+            mapData.InsertSystem(system);
+        }
+
+        auto write = [&mapData]()
+        {
+            QString text;
+            {
+                DataWriter writer(&text);
+                mapData.Save(writer);
+            }
+            return text;
+        };
+        QString base = write();
+        vector<System *> systems;
+        for(auto &it : mapData.Systems())
+            systems.push_back(&it.second);
+        vector<QVector2D> positions;
+        for(size_t i = 0; i < systems.size(); i += 50)
+        {
+            positions.push_back(systems[i]->Position());
+            systems[i]->SetPosition(positions.back() + QVector2D(10., 0.));
+        }
+        QString ours = write();
+        for(size_t i = 0; i < systems.size(); i += 50)
+            systems[i]->SetPosition(positions[i / 50]);
+        for(size_t i = 25; i < systems.size(); i += 50)
+            systems[i]->SetTrade("Food", 600);
+        QString theirs = write();
+
+        QString size = QString::number(systems.size()) + " systems ("
+            + QString::number(base.toUtf8().size() / 1024) + " KB)";
+        size_t changes = 0;
+        Time("merge: diff two maps of " + size, 1, [&]()
+        {
+            DataFile before;
+            DataFile after;
+            before.LoadText(base);
+            after.LoadText(ours);
+            changes = MapDiff::Diff(before, after).size();
+        });
+        size_t conflicts = 0;
+        Time("merge: merge three maps of " + size, 1, [&]()
+        {
+            DataFile files[3];
+            files[0].LoadText(base);
+            files[1].LoadText(ours);
+            files[2].LoadText(theirs);
+            QString merged;
+            DataWriter writer(&merged);
+            conflicts = MapDiff::Merge(files[0], files[1], files[2], writer).size();
+        });
+        cout << "merge: " << changes << " changes, " << conflicts << " conflicts." << endl;
+    }
+}
+
+
+
+// Check if the given argument is the name of a command.
+bool BatchMode::IsCommand(const QString &arg)
+{
+    return find(begin(COMMANDS), end(COMMANDS), arg) != end(COMMANDS);
+}
+
+
+
+// Run the command named by argv[1], and return its exit status.
+int BatchMode::Run(int &argc, char *argv[])
+{
+    QString command = argv[1];
+    vector<QString> args;
+    bool checkOnly = false;
+    bool force = false;
+    QString output;
+    RenderOptions options;
+    int count = 0;
+    for(int i = 2; i < argc; ++i)
+    {
+        QString arg = argv[i];
+        if(arg == "-h" || arg == "--help")
+        {
+            PrintHelp();
+            return SUCCESS;
+        }
+        else if((arg == "-j" || arg == "--jobs") && i + 1 < argc)
+        {
+            bool isNumber = false;
+            int jobs = QString(argv[++i]).toInt(&isNumber);
+            if(!isNumber || jobs < 1)
+                return Usage("The number of jobs must be at least 1.");
+            ParallelThreads() = jobs;
+        }
+        else if(command == "format" && arg == "--check")
+            checkOnly = true;
+        else if(command == "format" && arg == "--force")
+            force = true;
+        else if(command == "merge" && (arg == "-o" || arg == "--output") && i + 1 < argc)
+            output = argv[++i];
+        else if(command == "render" && arg == "--scale" && i + 1 < argc)
+            options.scale = QString(argv[++i]).toDouble();
+        else if(command == "render" && arg == "--commodity" && i + 1 < argc)
+            options.commodity = argv[++i];
+        else if(command == "render" && arg == "--government" && i + 1 < argc)
+            options.government = argv[++i];
+        else if(command == "render" && arg == "--heatmap")
+            options.heatmap = true;
+        else if(command == "benchmark" && arg == "--count" && i + 1 < argc)
+        {
+            count = QString(argv[++i]).toInt();
+            if(count < 1)
+                return Usage("The benchmark count must be at least 1.");
+        }
+        else if(arg.startsWith('-'))
+            return Usage("Unknown option \"" + arg + "\" for " + command + ".");
+        else
+            args.push_back(arg);
+    }
+
+    // Rendering needs fonts and images, and so a QGuiApplication, but it can
+    // use the offscreen platform instead of a display.
+    if(command == "render")
+    {
+        if(args.size() != 2)
+            return Usage("The render command needs a map file and an image file.");
+        if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        QGuiApplication app(argc, argv);
+        return Render(args[0], args[1], options);
+    }
+    // The asteroid field keeps its sprites as pixmaps, which also need a
+    // QGuiApplication, even if there are no sprites to load.
+    if(command == "benchmark")
+    {
+        if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        QGuiApplication app(argc, argv);
+        return Benchmark(args, count);
+    }
+
+    QCoreApplication app(argc, argv);
+    if(command == "query")
+    {
+        if(args.size() < 2)
+            return Usage("The query command needs a query and at least one map file.");
+        QString query = args.front();
+        args.erase(args.begin());
+        return Query(query, args);
+    }
+    if(command == "diff")
+    {
+        if(args.size() != 2)
+            return Usage("The diff command needs two files to compare.");
+        return Diff(args[0], args[1]);
+    }
+    if(command == "merge")
+    {
+        if(args.size() != 3)
+            return Usage("The merge command needs a base file and two changed versions of it.");
+        return Merge(args[0], args[1], args[2], output.isEmpty() ? args[1] : output);
+    }
+    if(args.empty())
+        return Usage("No map files were given.");
+    if(command == "validate")
+        return Validate(args);
+    if(command == "format")
+        return Format(args, checkOnly, force);
+    return Stats(args);
+}
+
+
+
+void BatchMode::PrintHelp()
+{
+    cerr << endl;
+    cerr << "Commands (run without a window, and then exit):" << endl;
+    cerr << "    validate <map.txt>...: check each map for consistency problems, and print" << endl;
+    cerr << "        each one as \"file:line: rule: message\"." << endl;
+    cerr << "    format [--check] [--force] <file>...: rewrite each file in the same form the" << endl;
+    cerr << "        editor saves it in. With --check, only list the files that would change." << endl;
+    cerr << "        WARNING: this form puts galaxies, then systems, then planets (each sorted" << endl;
+    cerr << "        by name) before everything else, and moves every comment to the top of" << endl;
+    cerr << "        the file. Files with comments anywhere else are skipped (and count as" << endl;
+    cerr << "        problems) unless --force is given." << endl;
+    cerr << "    stats <map.txt>...: print how many systems, planets, links, stellar objects," << endl;
+    cerr << "        and governments each map has." << endl;
+    cerr << "    query <query> <map.txt>...: print the definition of each system or planet" << endl;
+    cerr << "        with the given name, or if there are none, of each system that matches" << endl;
+    cerr << "        the query. A query is made of these conditions:" << endl;
+    for(const QString &line : QString(MapQuery::Help()).split('\n', Qt::SkipEmptyParts))
+        cerr << "            " << line.toStdString() << endl;
+    cerr << "    diff <before> <after>: list the systems, planets, and other entries that" << endl;
+    cerr << "        were added or removed, and the lines of each one that changed." << endl;
+    cerr << "    merge [-o <output>] <base> <ours> <theirs>: merge the changes both files" << endl;
+    cerr << "        made since the base file, entry by entry and line by line, and list any" << endl;
+    cerr << "        conflicts (where our version is kept). By default the result replaces" << endl;
+    cerr << "        our file, as git expects of a merge driver. The comments at the top of" << endl;
+    cerr << "        the files are merged as one block; if any file has comments after its" << endl;
+    cerr << "        first entry, nothing is written and this counts as a conflict." << endl;
+    cerr << "    render [options] <map.txt> <image>: draw the galaxy map into an image file." << endl;
+    cerr << "        Takes the --scale, --commodity, --government, and --heatmap options." << endl;
+    cerr << "    benchmark [--count <count>] [<name>...]: time parts of the editor on data" << endl;
+    cerr << "        generated in memory, with the given number of objects:" << endl;
+    cerr << "            asteroids: one step of an asteroid field (default: 100000)." << endl;
+    cerr << "            orbits: the positions of every stellar object on a given day, for" << endl;
+    cerr << "                random systems with this many objects in all (default: 1000000)." << endl;
+    cerr << "            region: filling a region with this many systems (default: 5000)." << endl;
+    cerr << "            merge: diffing and merging copies of a map with this many systems" << endl;
+    cerr << "                (default: 2000)." << endl;
+    cerr << endl;
+    cerr << "    -j, --jobs <count>: process this many files at once (default: one per core)." << endl;
+    cerr << endl;
+    cerr << "Exit status: 0 if all went well, 1 if problems, changes, or conflicts were" << endl;
+    cerr << "found (or a query found nothing), 2 if the command line was wrong, and 3 if a" << endl;
+    cerr << "file could not be read or written." << endl;
+    cerr << endl;
+}
+
+
+
+// Check each map for consistency problems, printing one line per problem.
+int BatchMode::Validate(const vector<QString> &paths)
+{
+    return ForEachFile(paths, [&paths](int i, Output &output)
+    {
+        const QString &path = paths[i];
+        Map mapData;
+        if(!LoadMap(path, mapData, output))
+            return;
+
+        for(const MapChecker::Finding &finding : MapChecker::Check(mapData))
+        {
+            output.out += MapChecker::Describe(mapData, finding) + '\n';
+            output.status = FOUND;
+        }
+    });
+}
+
+
+
+// Rewrite each file in the same form the editor saves it in. If only
+// checking, report the files that would change instead. That form puts all
+// the comments at the top of the file, so files with comments in any other
+// place are left alone unless forced.
+int BatchMode::Format(const vector<QString> &paths, bool checkOnly, bool force)
+{
+    return ForEachFile(paths, [&paths, checkOnly, force](int i, Output &output)
+    {
+        const QString &path = paths[i];
+        Map mapData;
+        if(!LoadMap(path, mapData, output))
+            return;
+        if(mapData.HasInteriorComments() && !force)
+        {
+            output.err += path + " has comments after its first entry, which formatting would move"
+                " to the top of the file. Use --force to format it anyway.\n";
+            output.status = FOUND;
+            return;
+        }
+
+        QFile file(path);
+        if(!file.open(QFile::ReadOnly))
+        {
+            output.err += "Unable to read \"" + path + "\".\n";
+            output.status = FILE_ERROR;
+            return;
+        }
+        QByteArray before = file.readAll();
+        file.close();
+
+        QString text;
+        {
+            DataWriter writer(&text);
+            mapData.Save(writer);
+        }
+        QByteArray after = text.toUtf8();
+        if(after == before)
+            return;
+
+        // Files that are already formatted are left alone, so their time
+        // stamps do not change.
+        if(checkOnly)
+        {
+            output.out += path + " is not formatted.\n";
+            output.status = FOUND;
+        }
+        else if(!file.open(QFile::WriteOnly) || file.write(after) != after.size())
+        {
+            output.err += "Unable to write \"" + path + "\".\n";
+            output.status = FILE_ERROR;
+        }
+        else
+            output.out += "Formatted " + path + ".\n";
+    });
+}
+
+
+
+// Print a summary of what each map contains.
+int BatchMode::Stats(const vector<QString> &paths)
+{
+    return ForEachFile(paths, [&paths](int i, Output &output)
+    {
+        const QString &path = paths[i];
+        Map mapData;
+        if(!LoadMap(path, mapData, output))
+            return;
+
+        // A link that only goes one way still counts as one link.
+        set<pair<QString, QString>> links;
+        set<QString> governments;
+        int objects = 0;
+        for(const auto &it : mapData.Systems())
+        {
+            for(const QString &link : it.second.Links())
+                links.insert(minmax(it.first, link));
+            if(!it.second.Government().isEmpty())
+                governments.insert(it.second.Government());
+            objects += it.second.Objects().size();
+        }
+
+        output.out += path + ": " + QString::number(mapData.Systems().size()) + " systems, "
+            + QString::number(mapData.Planets().size()) + " planets, "
+            + QString::number(links.size()) + " links, "
+            + QString::number(objects) + " stellar objects, "
+            + QString::number(governments.size()) + " governments\n";
+    });
+}
+
+
+
+// Print the definition of every system or planet with the given name. If
+// there are none, print every system that matches the query instead.
+int BatchMode::Query(const QString &query, const vector<QString> &paths)
+{
+    atomic<bool> isFound(false);
+    int status = ForEachFile(paths, [&paths, &query, &isFound](int i, Output &output)
+    {
+        const QString &path = paths[i];
+        Map mapData;
+        if(!LoadMap(path, mapData, output))
+            return;
+
+        QString text;
+        {
+            DataWriter writer(&text);
+            auto write = [&path, &writer, &isFound](const auto &object)
+            {
+                writer.WriteComment(path + ":" + QString::number(object.SourceLine()));
+                object.Save(writer);
+                isFound = true;
+            };
+            auto system = mapData.Systems().find(query);
+            if(system != mapData.Systems().end())
+                write(system->second);
+            auto planet = mapData.Planets().find(query);
+            if(planet != mapData.Planets().end())
+                write(planet->second);
+
+            if(system == mapData.Systems().end() && planet == mapData.Planets().end())
+            {
+                vector<QString> matches;
+                QString error;
+                if(!MapQuery(mapData).Find(query, matches, error))
+                {
+                    output.err += path + ": " + error + "\n";
+                    output.status = USAGE;
+                    return;
+                }
+                for(const QString &name : matches)
+                    write(mapData.Systems().at(name));
+            }
+        }
+        output.out += text;
+    });
+    if(status == SUCCESS && !isFound)
+    {
+        cerr << "Nothing matches \"" << query.toStdString() << "\"." << endl;
+        return FOUND;
+    }
+    return status;
+}
+
+
+
+// List the differences between two files, entity by entity.
+int BatchMode::Diff(const QString &before, const QString &after)
+{
+    vector<DataFile> files;
+    int status = LoadFiles({before, after}, files);
+    if(status != SUCCESS)
+        return status;
+
+    vector<MapDiff::Change> changes = MapDiff::Diff(files[0], files[1]);
+    for(const MapDiff::Change &change : changes)
+        cout << MapDiff::Describe(change).toStdString() << endl;
+    return changes.empty() ? SUCCESS : FOUND;
+}
+
+
+
+// Merge the changes both sides made since the base file, and write the
+// result to the output file. Conflicting changes keep our version.
+int BatchMode::Merge(const QString &base, const QString &ours, const QString &theirs, const QString &output)
+{
+    vector<DataFile> files;
+    int status = LoadFiles({base, ours, theirs}, files);
+    if(status != SUCCESS)
+        return status;
+
+    // The merged file only has comments at the top, so rather than move any
+    // others there, leave our file as it is (which git treats as a conflict).
+    const QString paths[3] = {base, ours, theirs};
+    for(int i = 0; i < 3; ++i)
+        if(files[i].HasInteriorComments())
+        {
+            cerr << paths[i].toStdString() << " has comments after its first entry, which merging"
+                " would move to the top of the file. Merge it by hand." << endl;
+            return FOUND;
+        }
+
+    QString text;
+    vector<MapDiff::Conflict> conflicts;
+    {
+        DataWriter writer(&text);
+        conflicts = MapDiff::Merge(files[0], files[1], files[2], writer);
+    }
+    status = WriteFile(output, text.toUtf8());
+    if(status != SUCCESS)
+        return status;
+
+    for(const MapDiff::Conflict &conflict : conflicts)
+        cout << "Conflict: " << MapDiff::Describe(conflict).toStdString() << endl;
+    return conflicts.empty() ? SUCCESS : FOUND;
+}
+
+
+
+// Draw the whole galaxy map into an image file. This needs at least a
+// QGuiApplication, but not a display.
+int BatchMode::Render(const QString &mapPath, const QString &imagePath, const RenderOptions &options)
+{
+    if(!(options.scale > 0.))
+    {
+        cerr << "The render scale must be greater than zero." << endl;
+        return USAGE;
+    }
+
+    Map mapData;
+    Output output;
+    if(!LoadMap(mapPath, mapData, output))
+    {
+        cerr << output.err.toStdString();
+        return output.status;
+    }
+
+    GalaxyRenderer renderer(mapData);
+    renderer.SetHeatmap(options.heatmap);
+    if(!options.commodity.isEmpty())
+        renderer.SetCommodity(options.commodity);
+    else if(!options.government.isEmpty())
+        renderer.SetGovernment(options.government);
+
+    QRectF bounds = renderer.Bounds();
+    QImage image = renderer.Render(bounds, options.scale);
+    if(image.isNull())
+    {
+        cerr << "Unable to allocate a " << ceil(bounds.width() * options.scale)
+            << " by " << ceil(bounds.height() * options.scale) << " image." << endl;
+        return FILE_ERROR;
+    }
+    if(!image.save(imagePath))
+    {
+        cerr << "Unable to write \"" << imagePath.toStdString() << "\"." << endl;
+        return FILE_ERROR;
+    }
+    return SUCCESS;
+}
+
+
+
+// Time the given parts of the editor on generated data of the given size (or
+// a default size for each, if it is zero), and print the results.
+int BatchMode::Benchmark(const vector<QString> &names, int count)
+{
+    vector<QString> list = names;
+    if(list.empty())
+        list.assign(begin(BENCHMARKS), end(BENCHMARKS));
+    for(const QString &name : list)
+        if(find(begin(BENCHMARKS), end(BENCHMARKS), name) == end(BENCHMARKS))
+            return Usage("Unknown benchmark \"" + name + "\".");
+
+    for(const QString &name : list)
+    {
+        if(name == "asteroids")
+            BenchmarkAsteroids(count ? count : 100000);
+        else if(name == "orbits")
+            BenchmarkOrbits(count ? count : 1000000);
+        else if(name == "region")
+            BenchmarkRegion(count ? count : 5000);
+        else if(name == "merge")
+            BenchmarkMerge(count ? count : 2000);
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,84 @@
+/* BatchMode.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef BATCHMODE_H_
+#define BATCHMODE_H_
+
+#include <QString>
+
+#include <vector>
+
+
+
+// Class for running the editor as a command line tool, without a window, e.g.
+// as part of an automated build. Each command only uses the map data layer,
+// and (except for rendering) only needs a QCoreApplication. Commands that take
+// many map files load and process them in parallel, but print their results in
+// the order the files were given, so the output does not depend on timing.
+class BatchMode {
+public:
+    // The exit status of a command. If it processes several files, the worst
+    // (i.e. highest) status of any of them is returned.
+    enum ExitCode {
+        SUCCESS = 0,
+        // Something was found that needs fixing, or a query found nothing.
+        FOUND = 1,
+        // The command line was not understood.
+        USAGE = 2,
+        // A file could not be read or written.
+        FILE_ERROR = 3
+    };
+    struct RenderOptions {
+        double scale = 1.;
+        QString commodity;
+        QString government;
+        bool heatmap = false;
+    };
+
+
+public:
+    // Check if the given argument is the name of a command.
+    static bool IsCommand(const QString &arg);
+    // Run the command named by argv[1], and return its exit status.
+    static int Run(int &argc, char *argv[]);
+    static void PrintHelp();
+
+    // These commands assume an application object already exists.
+    // Check each map for consistency problems, printing one line per problem.
+    static int Validate(const std::vector<QString> &paths);
+    // Rewrite each file in the same form the editor saves it in. If only
+    // checking, report the files that would change instead. That form puts
+    // all the comments at the top of the file, so files with comments in any
+    // other place are left alone unless forced.
+    static int Format(const std::vector<QString> &paths, bool checkOnly, bool force);
+    // Print a summary of what each map contains.
+    static int Stats(const std::vector<QString> &paths);
+    // Print the definition of every system or planet with the given name. If
+    // there are none, print every system that matches the query instead.
+    static int Query(const QString &query, const std::vector<QString> &paths);
+    // List the differences between two files, entity by entity.
+    static int Diff(const QString &before, const QString &after);
+    // Merge the changes both sides made since the base file, and write the
+    // result to the output file. Conflicting changes keep our version.
+    static int Merge(const QString &base, const QString &ours, const QString &theirs, const QString &output);
+    // Draw the whole galaxy map into an image file. This needs at least a
+    // QGuiApplication, but not a display.
+    static int Render(const QString &mapPath, const QString &imagePath, const RenderOptions &options);
+    // Time the given parts of the editor on generated data of the given size
+    // (or a default size for each, if it is zero), and print the results.
+    // This also needs a QGuiApplication.
+    static int Benchmark(const std::vector<QString> &names, int count);
+};
+
+
+
+#endif
@@ -39,14 +39,63 @@ void DataFile::Load(const QString &path)
     if(!file.open(QFile::ReadOnly | QFile::Text))
         return;
     QTextStream in(&file);
+    Read(in);
+}
+
+
+
+// Read data from a string instead of a file.
+void DataFile::LoadText(const QString &text)
+{
+    QString copy = text;
+    QTextStream in(&copy, QIODevice::ReadOnly);
+    Read(in);
+}
+
+
+
+list<DataNode>::const_iterator DataFile::begin() const
+{
+    return root.begin();
+}
+
+
+
+list<DataNode>::const_iterator DataFile::end() const
+{
+    return root.end();
+}
+
+// Get all the comments that were stripped out when reading.
+const QString &DataFile::Comments() const
+{
+    return comments;
+}
+
+
 
+// Check if any comments came after the first node. Saving only writes the
+// comments at the top of the file, so those would be moved there.
+bool DataFile::HasInteriorComments() const
+{
+    return hasInteriorComments;
+}
+
+
+
+// Each node's hash is finished when the last of its children has been read,
+// and then added to its parent's hash.
+void DataFile::Read(QTextStream &in)
+{
     vector<DataNode *> stack(1, &root);
     vector<int> whiteStack(1, -1);
+    int lineNumber = 0;
 
     while(!in.atEnd())
     {
         QString line = in.readLine();
         int length = line.length();
+        ++lineNumber;
 
         int white = 0;
         while(white < length && line[white].isSpace())
@@ -59,18 +108,22 @@ void DataFile::Load(const QString &path)
             {
                 comments += line;
                 comments += '\n';
+                hasInteriorComments |= root.HasChildren();
             }
             continue;
         }
         while(whiteStack.back() >= white)
         {
             whiteStack.pop_back();
+            uint64_t hash = stack.back()->hash;
             stack.pop_back();
+            DataNode::HashChild(stack.back()->hash, hash);
         }
 
         list<DataNode> &children = stack.back()->children;
         children.push_back(DataNode());
         DataNode &node = children.back();
+        node.lineNumber = lineNumber;
 
         stack.push_back(&node);
         whiteStack.push_back(white);
@@ -86,6 +139,7 @@ void DataFile::Load(const QString &path)
             node.tokens.push_back(QString());
             while(i != length && (isQuoted ? (line[i] != endQuote) : (line[i] > ' ')))
                 node.tokens.back() += line[i++];
+            DataNode::HashToken(node.hash, node.tokens.back());
 
             if(i != length)
             {
@@ -95,24 +149,11 @@ void DataFile::Load(const QString &path)
             }
         }
     }
-}
-
-
-
-list<DataNode>::const_iterator DataFile::begin() const
-{
-    return root.begin();
-}
-
-
-
-list<DataNode>::const_iterator DataFile::end() const
-{
-    return root.end();
-}
-
-// Get all the comments that were stripped out when reading.
-const QString &DataFile::Comments() const
-{
-    return comments;
+    // Finish the nodes that are still open at the end of the file.
+    while(stack.size() > 1)
+    {
+        uint64_t hash = stack.back()->hash;
+        stack.pop_back();
+        DataNode::HashChild(stack.back()->hash, hash);
+    }
 }
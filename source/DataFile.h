@@ -19,6 +19,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <list>
 
+class QTextStream;
+
 
 
 // A class which represents a hierarchical data file. Each line of the file that
@@ -33,17 +35,27 @@ public:
     DataFile(const QString &path);
 
     void Load(const QString &path);
+    // Read data from a string instead of a file.
+    void LoadText(const QString &text);
 
     std::list<DataNode>::const_iterator begin() const;
     std::list<DataNode>::const_iterator end() const;
 
     // Get all the comments that were stripped out when reading.
     const QString &Comments() const;
+    // Check if any comments came after the first node. Saving only writes the
+    // comments at the top of the file, so those would be moved there.
+    bool HasInteriorComments() const;
+
+
+private:
+    void Read(QTextStream &in);
 
 
 private:
     DataNode root;
     QString comments;
+    bool hasInteriorComments = false;
 };
 
 
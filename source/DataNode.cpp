@@ -17,6 +17,16 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 using namespace std;
 
+namespace {
+    // Node hashes are 64-bit FNV-1a, over the UTF-16 code units of each token
+    // and then the hash of each child, so they are the same on every platform.
+    const uint64_t FNV_PRIME = 1099511628211ull;
+    // Values outside the range of a code unit, marking the end of each token
+    // and the start of each child.
+    const uint64_t END_TOKEN = 0x10000;
+    const uint64_t BEGIN_CHILD = 0x10001;
+}
+
 
 
 int DataNode::Size() const
@@ -40,6 +50,46 @@ double DataNode::Value(int index) const
 
 
 
+// Get the line of the file this node was read from, counting from 1, or 0
+// if it was not read from a file.
+int DataNode::LineNumber() const
+{
+    return lineNumber;
+}
+
+
+
+// Get a 64-bit hash of this node's tokens and all its children, which is
+// the same in every run and on every platform. It is computed as the node
+// is read, so checking if two nodes differ costs nothing.
+uint64_t DataNode::Hash() const
+{
+    return hash;
+}
+
+
+
+// Add a token, or the hash of a finished child, to a node's hash. DataFile
+// and DataWriter both hash nodes this way, so a node written by the editor
+// hashes the same as the node it would be read back as.
+void DataNode::HashToken(uint64_t &hash, const QString &token)
+{
+    for(const QChar &c : token)
+        hash = (hash ^ c.unicode()) * FNV_PRIME;
+    hash = (hash ^ END_TOKEN) * FNV_PRIME;
+}
+
+
+
+void DataNode::HashChild(uint64_t &hash, uint64_t child)
+{
+    hash = (hash ^ BEGIN_CHILD) * FNV_PRIME;
+    for(int shift = 0; shift < 64; shift += 8)
+        hash = (hash ^ ((child >> shift) & 0xFF)) * FNV_PRIME;
+}
+
+
+
 bool DataNode::HasChildren() const
 {
     return !children.empty();
@@ -15,6 +15,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <QString>
 
+#include <cstdint>
 #include <list>
 #include <string>
 #include <vector>
@@ -32,6 +33,20 @@ public:
     int Size() const;
     const QString &Token(int index) const;
     double Value(int index) const;
+    // Get the line of the file this node was read from, counting from 1, or 0
+    // if it was not read from a file.
+    int LineNumber() const;
+    // Get a 64-bit hash of this node's tokens and all its children, which is
+    // the same in every run and on every platform. It is computed as the node
+    // is read, so checking if two nodes differ costs nothing.
+    uint64_t Hash() const;
+    // Add a token, or the hash of a finished child, to a node's hash. DataFile
+    // and DataWriter both hash nodes this way, so a node written by the editor
+    // hashes the same as the node it would be read back as.
+    static void HashToken(uint64_t &hash, const QString &token);
+    static void HashChild(uint64_t &hash, uint64_t child);
+    // The hash of a node with no tokens or children.
+    static constexpr uint64_t EMPTY_HASH = 14695981039346656037ull;
 
     bool HasChildren() const;
     std::list<DataNode>::const_iterator begin() const;
@@ -41,6 +56,8 @@ public:
 private:
     std::list<DataNode> children;
     std::vector<QString> tokens;
+    int lineNumber = 0;
+    uint64_t hash = EMPTY_HASH;
 
     friend class DataFile;
 };
@@ -35,6 +35,34 @@ DataWriter::DataWriter(const QString &path)
 
 
 
+// Write into the given string instead of a file.
+DataWriter::DataWriter(QString *text)
+    : before(&indent)
+{
+    out.setString(text);
+}
+
+
+
+// Write nothing, but hash each node as DataFile would if it read the
+// nodes back, and store the hash of the last top-level node in the given
+// variable when this writer is destroyed.
+DataWriter::DataWriter(uint64_t *hash)
+    : before(&indent), hash(hash), hashes(1, DataNode::EMPTY_HASH), depths(1, -1)
+{
+}
+
+
+
+DataWriter::~DataWriter()
+{
+    if(hash)
+        while(hashes.size() > 1)
+            EndNode();
+}
+
+
+
 void DataWriter::Write(const DataNode &node)
 {
     for(int i = 0; i < node.Size(); ++i)
@@ -56,7 +84,8 @@ void DataWriter::Write(const DataNode &node)
 
 void DataWriter::Write()
 {
-    out << '\n';
+    if(!hash)
+        out << '\n';
     before = &indent;
 }
 
@@ -78,20 +107,31 @@ void DataWriter::EndChild()
 
 void DataWriter::WriteComment(const QString &str)
 {
-    out << indent << "# " << str << '\n';
+    if(!hash)
+        out << indent << "# " << str << '\n';
 }
 
 
 
 void DataWriter::WriteRaw(const QString &str)
 {
-    out << str;
+    if(!hash)
+        out << str;
 }
 
 
 
 void DataWriter::WriteToken(const QString &str, QChar quote)
 {
+    if(hash)
+    {
+        if(before == &indent)
+            BeginNode();
+        DataNode::HashToken(hashes.back(), str);
+        before = &space;
+        return;
+    }
+
     bool hasSpace = str.isEmpty() || (quote == '"');
     bool hasQuote = (quote == '`');
     for(QChar c : str)
@@ -109,3 +149,28 @@ void DataWriter::WriteToken(const QString &str, QChar quote)
         out << str;
     before = &space;
 }
+
+
+
+// Start hashing a node for the line that is being begun, after finishing
+// any nodes that are not its parents.
+void DataWriter::BeginNode()
+{
+    int depth = indent.length();
+    while(depths.back() >= depth)
+        EndNode();
+    hashes.push_back(DataNode::EMPTY_HASH);
+    depths.push_back(depth);
+}
+
+
+
+void DataWriter::EndNode()
+{
+    uint64_t child = hashes.back();
+    hashes.pop_back();
+    depths.pop_back();
+    DataNode::HashChild(hashes.back(), child);
+    if(hashes.size() == 1)
+        *hash = child;
+}
@@ -17,6 +17,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <QString>
 #include <QTextStream>
 
+#include <cstdint>
+#include <vector>
+
 class DataNode;
 
 
@@ -29,6 +32,13 @@ class DataNode;
 class DataWriter {
 public:
     DataWriter(const QString &path);
+    // Write into the given string instead of a file.
+    explicit DataWriter(QString *text);
+    // Write nothing, but hash each node as DataFile would if it read the
+    // nodes back, and store the hash of the last top-level node in the given
+    // variable when this writer is destroyed.
+    explicit DataWriter(uint64_t *hash);
+    ~DataWriter();
 
   template <class ...B>
     void Write(const char *a, B... others);
@@ -49,6 +59,13 @@ public:
     void WriteToken(const QString &str, QChar quote = '\0');
 
 
+private:
+    // Start hashing a node for the line that is being begun, after finishing
+    // any nodes that are not its parents.
+    void BeginNode();
+    void EndNode();
+
+
 private:
     QString indent;
     static const QString space;
@@ -56,6 +73,12 @@ private:
 
     QFile file;
     QTextStream out;
+
+    // If hashing, the hashes and indentation of the nodes that are still open.
+    // The first one is the root, which contains every top-level node.
+    uint64_t *hash = nullptr;
+    std::vector<uint64_t> hashes;
+    std::vector<int> depths;
 };
 
 
@@ -84,8 +107,18 @@ void DataWriter::Write(const A &a, B... others)
     static_assert(std::is_arithmetic<A>::value,
         "DataWriter cannot output anything but strings and arithmetic types.");
 
-    out << *before << a;
-    before = &space;
+    if(hash)
+    {
+        // Hash the number as the text it would be written as.
+        QString token;
+        QTextStream(&token) << a;
+        WriteToken(token);
+    }
+    else
+    {
+        out << *before << a;
+        before = &space;
+    }
 
     Write(others...);
 }
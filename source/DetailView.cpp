@@ -12,6 +12,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "DetailView.h"
 
+#include "EditHistory.h"
 #include "GalaxyView.h"
 #include "Map.h"
 #include "System.h"
@@ -28,6 +29,10 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <QTreeWidget>
 #include <QVBoxLayout>
 
+#include <cmath>
+#include <optional>
+#include <utility>
+
 using namespace std;
 
 namespace {
@@ -201,6 +206,8 @@ void DetailView::SetSystem(System *system)
     if(system == this->system)
         return;
 
+    // Price changes in a different system should not be merged together.
+    mapData.History().Seal();
     this->system = system;
     if(system)
     {
@@ -282,6 +289,16 @@ void DetailView::SetSystem(System *system)
 
 
 
+// Refresh all the fields, after the system was changed from elsewhere.
+void DetailView::Reload()
+{
+    System *current = system;
+    system = nullptr;
+    SetSystem(current);
+}
+
+
+
 void DetailView::UpdateMinables()
 {
     if(!system || !minables)
@@ -389,11 +406,13 @@ void DetailView::DisplayNameChanged()
         return;
     if(system->DisplayName().isEmpty() && displayName->text() == system->TrueName())
         return;
+    EditHistory::DetailValue before = system->HasDisplayName() ? optional<QString>(system->DisplayName()) : nullopt;
     if(displayName->text() == system->TrueName())
         system->SetDisplayName(QString());
     else
         system->SetDisplayName(displayName->text());
-    mapData.SetChanged();
+    mapData.History().SetDetails(*system, {{EditHistory::DISPLAY_NAME, before}});
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -404,9 +423,10 @@ void DetailView::GovernmentChanged()
     if(!system || system->Government() == newGov || newGov.isEmpty())
         return;
 
+    mapData.History().SetGovernment({system->TrueName()}, {system->Government()}, newGov);
     system->SetGovernment(newGov);
     galaxyView->SetGovernment(newGov);
-    mapData.SetChanged();
+    mapData.SetChanged(true, Map::GOVERNMENTS);
 
     // Refresh the Galaxy map since it is using a new Government color.
     galaxyView->update();
@@ -420,7 +440,8 @@ void DetailView::HiddenClicked()
         return;
 
     system->ToggleHidden();
-    mapData.SetChanged();
+    mapData.History().ToggleHidden({system->TrueName()});
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -431,7 +452,8 @@ void DetailView::ShroudedClicked()
         return;
 
     system->ToggleShrouded();
-    mapData.SetChanged();
+    mapData.History().SetDetails(*system, {{EditHistory::SHROUDED, !system->Shrouded()}});
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -442,7 +464,8 @@ void DetailView::InaccessibleClicked()
         return;
 
     system->ToggleInaccessible();
-    mapData.SetChanged();
+    mapData.History().SetDetails(*system, {{EditHistory::INACCESSIBLE, !system->Inaccessible()}});
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -452,8 +475,14 @@ void DetailView::JumpRangeChanged()
     if(!system)
         return;
 
-    system->SetJumpRange(jumpRange->text().toDouble());
-    mapData.SetChanged();
+    double before = system->JumpRange();
+    double value = jumpRange->text().toDouble();
+    if(value == before)
+        return;
+
+    system->SetJumpRange(value);
+    mapData.History().SetDetails(*system, {{EditHistory::JUMP_RANGE, before}});
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -463,8 +492,14 @@ void DetailView::HyperArrivalChanged()
     if(!system)
         return;
 
-    system->SetHyperArrival(hyperArrival->text().toDouble());
-    mapData.SetChanged();
+    double before = system->HyperArrival();
+    double value = hyperArrival->text().toDouble();
+    if(value == before)
+        return;
+
+    system->SetHyperArrival(value);
+    mapData.History().SetDetails(*system, {{EditHistory::HYPER_ARRIVAL, before}});
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -474,8 +509,14 @@ void DetailView::JumpArrivalChanged()
     if(!system)
         return;
 
-    system->SetJumpArrival(jumpArrival->text().toDouble());
-    mapData.SetChanged();
+    double before = system->JumpArrival();
+    double value = jumpArrival->text().toDouble();
+    if(value == before)
+        return;
+
+    system->SetJumpArrival(value);
+    mapData.History().SetDetails(*system, {{EditHistory::JUMP_ARRIVAL, before}});
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -487,6 +528,8 @@ void DetailView::ArrivalFromHabitableClicked()
 
     if(arrivalFromHabitable->isChecked())
     {
+        mapData.History().SetDetails(*system, {{EditHistory::HYPER_ARRIVAL, system->HyperArrival()},
+            {EditHistory::JUMP_ARRIVAL, system->JumpArrival()}});
         hyperArrival->setReadOnly(true);
         hyperArrival->setText(QString::number(system->HabitableZone()));
         system->SetHyperArrival(system->HabitableZone());
@@ -500,7 +543,7 @@ void DetailView::ArrivalFromHabitableClicked()
         jumpArrival->setReadOnly(false);
     }
 
-    mapData.SetChanged();
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -510,8 +553,14 @@ void DetailView::HyperDepartureChanged()
     if(!system)
         return;
 
-    system->SetHyperDeparture(hyperDeparture->text().toDouble());
-    mapData.SetChanged();
+    double before = system->HyperDeparture();
+    double value = hyperDeparture->text().toDouble();
+    if(value == before)
+        return;
+
+    system->SetHyperDeparture(value);
+    mapData.History().SetDetails(*system, {{EditHistory::HYPER_DEPARTURE, before}});
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -521,8 +570,14 @@ void DetailView::JumpDepartureChanged()
     if(!system)
         return;
 
-    system->SetJumpDeparture(jumpDeparture->text().toDouble());
-    mapData.SetChanged();
+    double before = system->JumpDepature();
+    double value = jumpDeparture->text().toDouble();
+    if(value == before)
+        return;
+
+    system->SetJumpDeparture(value);
+    mapData.History().SetDetails(*system, {{EditHistory::JUMP_DEPARTURE, before}});
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -536,7 +591,8 @@ void DetailView::RamscoopUniversalClicked()
         return;
 
     system->ToggleRamscoopUniversal();
-    mapData.SetChanged();
+    mapData.History().SetDetails(*system, {{EditHistory::RAMSCOOP_UNIVERSAL, !system->HasRamscoopUniversal()}});
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -546,8 +602,14 @@ void DetailView::RamscoopAddendChanged()
     if(!system)
         return;
 
-    system->SetRamscoopAddend(GetOptionalValue(ramscoopAddend->text()));
-    mapData.SetChanged();
+    double before = system->RamscoopAddend();
+    double value = GetOptionalValue(ramscoopAddend->text());
+    if(value == before || (isnan(value) && isnan(before)))
+        return;
+
+    system->SetRamscoopAddend(value);
+    mapData.History().SetDetails(*system, {{EditHistory::RAMSCOOP_ADDEND, before}});
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -557,8 +619,14 @@ void DetailView::RamscoopMultiplierChanged()
     if(!system)
         return;
 
-    system->SetRamscoopMultiplier(GetOptionalValue(ramscoopMultiplier->text()));
-    mapData.SetChanged();
+    double before = system->RamscoopMultiplier();
+    double value = GetOptionalValue(ramscoopMultiplier->text());
+    if(value == before || (isnan(value) && isnan(before)))
+        return;
+
+    system->SetRamscoopMultiplier(value);
+    mapData.History().SetDetails(*system, {{EditHistory::RAMSCOOP_MULTIPLIER, before}});
+    mapData.SetChanged(true, Map::DETAILS);
 }
 
 
@@ -579,9 +647,12 @@ void DetailView::CommodityChanged(int value)
 
     tradeWidget->setCurrentItem(it->second);
     CommodityClicked(it->second, 0);
-    system->SetTrade(it->second->text(0), value);
+    // Stepping the spin box repeatedly is recorded as a single edit.
+    const QString &commodity = it->second->text(0);
+    mapData.History().SetTrade(commodity, {system->TrueName()}, {system->Trade(commodity)}, {value}, true);
+    system->SetTrade(commodity, value);
     it->second->setText(2, mapData.PriceLevel(it->second->text(0), value));
-    mapData.SetChanged();
+    mapData.SetChanged(true, Map::TRADE);
     galaxyView->update();
 }
 
@@ -592,6 +663,7 @@ void DetailView::FleetChanged(QTreeWidgetItem *item, int column)
     if(!system)
         return;
 
+    vector<PeriodicEvent> before = system->Fleets();
     unsigned row = item->text(2).toInt();
     if(row == system->Fleets().size())
         system->Fleets().emplace_back(item->text(0), item->text(1).toInt());
@@ -604,7 +676,8 @@ void DetailView::FleetChanged(QTreeWidgetItem *item, int column)
     else
         return;
 
-    mapData.SetChanged();
+    mapData.History().SetDetails(*system, {{EditHistory::FLEETS, std::move(before)}});
+    mapData.SetChanged(true, Map::DETAILS);
 
     UpdateFleets();
 }
@@ -616,6 +689,7 @@ void DetailView::MinablesChanged(QTreeWidgetItem *item, int column)
     if(!system)
         return;
 
+    vector<System::Minable> before = system->Minables();
     unsigned row = item->text(2).toInt();
     if(row == system->Minables().size())
         system->Minables().emplace_back(item->text(0), item->text(1).toInt(), item->text(2).toDouble());
@@ -630,7 +704,8 @@ void DetailView::MinablesChanged(QTreeWidgetItem *item, int column)
     else
         return;
 
-    mapData.SetChanged();
+    mapData.History().SetDetails(*system, {{EditHistory::MINABLES, std::move(before)}});
+    mapData.SetChanged(true, Map::DETAILS);
 
     UpdateMinables();
 }
@@ -642,6 +717,7 @@ void DetailView::HazardChanged(QTreeWidgetItem *item, int column)
     if(!system)
         return;
 
+    vector<PeriodicEvent> before = system->Hazards();
     unsigned row = item->text(2).toInt();
     if(row == system->Hazards().size())
         system->Hazards().emplace_back(item->text(0), item->text(1).toInt());
@@ -654,7 +730,8 @@ void DetailView::HazardChanged(QTreeWidgetItem *item, int column)
     else
         return;
 
-    mapData.SetChanged();
+    mapData.History().SetDetails(*system, {{EditHistory::HAZARDS, std::move(before)}});
+    mapData.SetChanged(true, Map::DETAILS);
 
     UpdateHazards();
 }
@@ -667,13 +744,14 @@ void DetailView::RaidsDisabledClicked()
         return;
 
     system->ToggleRaids();
+    mapData.History().SetDetails(*system, {{EditHistory::RAIDS_DISABLED, !system->RaidsDisabled()}});
 
     bool disableRaids = raidsDisabled->isChecked();
     raidsCustom->setDisabled(disableRaids);
     raidsCustom->setChecked(disableRaids);
     raidsCustom->setCheckable(!disableRaids);
 
-    mapData.SetChanged();
+    mapData.SetChanged(true, Map::DETAILS);
 
     UpdateRaidFleets();
 }
@@ -698,6 +776,7 @@ void DetailView::RaidFleetsChanged(QTreeWidgetItem *item, int column)
     if(!system)
         return;
 
+    vector<System::RaidFleet> before = system->RaidFleets();
     unsigned row = item->text(3).toInt();
     if(row == system->RaidFleets().size())
         system->RaidFleets().emplace_back(item->text(0), item->text(1).toInt(), item->text(2).toInt());
@@ -712,7 +791,8 @@ void DetailView::RaidFleetsChanged(QTreeWidgetItem *item, int column)
     else
         return;
 
-    mapData.SetChanged();
+    mapData.History().SetDetails(*system, {{EditHistory::RAID_FLEETS, std::move(before)}});
+    mapData.SetChanged(true, Map::DETAILS);
 
     UpdateRaidFleets();
 }
@@ -38,6 +38,8 @@ public:
     explicit DetailView(Map &mapData, GalaxyView *galaxyView, QWidget *parent = 0);
 
     void SetSystem(System *system);
+    // Refresh all the fields, after the system was changed from elsewhere.
+    void Reload();
     void UpdateMinables();
     void UpdateCommodities();
     bool eventFilter(QObject* object, QEvent* event);
@@ -0,0 +1,725 @@
+/* EditHistory.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "EditHistory.h"
+
+#include "Map.h"
+
+#include <utility>
+
+using namespace std;
+
+namespace {
+    size_t budget = 64 << 20;
+
+    size_t StringBytes(const QString &text)
+    {
+        return sizeof(QString) + text.size() * sizeof(QChar);
+    }
+
+    size_t ObjectBytes(const vector<StellarObject> &objects)
+    {
+        size_t total = 0;
+        for(const StellarObject &object : objects)
+            total += sizeof(StellarObject) + (object.Sprite().size() + object.GetPlanet().size()) * sizeof(QChar);
+        return total;
+    }
+
+    // The name of each detail view field, for describing edits to it.
+    const char *DETAIL_NAMES[] = {
+        "display name",
+        "shrouded",
+        "inaccessible",
+        "jump range",
+        "hyperspace arrival",
+        "jump arrival",
+        "hyperspace departure",
+        "jump departure",
+        "universal ramscoop",
+        "ramscoop addend",
+        "ramscoop multiplier",
+        "fleets",
+        "minables",
+        "hazards",
+        "raids disabled",
+        "raid fleets"
+    };
+
+    EditHistory::DetailValue GetDetail(const System &system, EditHistory::Detail detail)
+    {
+        switch(detail)
+        {
+            case EditHistory::DISPLAY_NAME:
+                return system.HasDisplayName() ? optional<QString>(system.DisplayName()) : nullopt;
+            case EditHistory::SHROUDED:
+                return system.Shrouded();
+            case EditHistory::INACCESSIBLE:
+                return system.Inaccessible();
+            case EditHistory::JUMP_RANGE:
+                return system.JumpRange();
+            case EditHistory::HYPER_ARRIVAL:
+                return system.HyperArrival();
+            case EditHistory::JUMP_ARRIVAL:
+                return system.JumpArrival();
+            case EditHistory::HYPER_DEPARTURE:
+                return system.HyperDeparture();
+            case EditHistory::JUMP_DEPARTURE:
+                return system.JumpDepature();
+            case EditHistory::RAMSCOOP_UNIVERSAL:
+                return system.HasRamscoopUniversal();
+            case EditHistory::RAMSCOOP_ADDEND:
+                return system.RamscoopAddend();
+            case EditHistory::RAMSCOOP_MULTIPLIER:
+                return system.RamscoopMultiplier();
+            case EditHistory::FLEETS:
+                return system.Fleets();
+            case EditHistory::MINABLES:
+                return system.Minables();
+            case EditHistory::HAZARDS:
+                return system.Hazards();
+            case EditHistory::RAIDS_DISABLED:
+                return system.RaidsDisabled();
+            case EditHistory::RAID_FLEETS:
+                return system.RaidFleets();
+        }
+        return false;
+    }
+
+    void SetDetail(System &system, const EditHistory::Field &field)
+    {
+        // The yes or no fields can only be toggled.
+        const bool *flag = get_if<bool>(&field.value);
+        switch(field.detail)
+        {
+            case EditHistory::DISPLAY_NAME:
+                system.SetDisplayName(get<optional<QString>>(field.value));
+                break;
+            case EditHistory::SHROUDED:
+                if(*flag != system.Shrouded())
+                    system.ToggleShrouded();
+                break;
+            case EditHistory::INACCESSIBLE:
+                if(*flag != system.Inaccessible())
+                    system.ToggleInaccessible();
+                break;
+            case EditHistory::JUMP_RANGE:
+                system.SetJumpRange(get<double>(field.value));
+                break;
+            case EditHistory::HYPER_ARRIVAL:
+                system.SetHyperArrival(get<double>(field.value));
+                break;
+            case EditHistory::JUMP_ARRIVAL:
+                system.SetJumpArrival(get<double>(field.value));
+                break;
+            case EditHistory::HYPER_DEPARTURE:
+                system.SetHyperDeparture(get<double>(field.value));
+                break;
+            case EditHistory::JUMP_DEPARTURE:
+                system.SetJumpDeparture(get<double>(field.value));
+                break;
+            case EditHistory::RAMSCOOP_UNIVERSAL:
+                if(*flag != system.HasRamscoopUniversal())
+                    system.ToggleRamscoopUniversal();
+                break;
+            case EditHistory::RAMSCOOP_ADDEND:
+                system.SetRamscoopAddend(get<double>(field.value));
+                break;
+            case EditHistory::RAMSCOOP_MULTIPLIER:
+                system.SetRamscoopMultiplier(get<double>(field.value));
+                break;
+            case EditHistory::FLEETS:
+                system.Fleets() = get<vector<PeriodicEvent>>(field.value);
+                break;
+            case EditHistory::MINABLES:
+                system.Minables() = get<vector<System::Minable>>(field.value);
+                break;
+            case EditHistory::HAZARDS:
+                system.Hazards() = get<vector<PeriodicEvent>>(field.value);
+                break;
+            case EditHistory::RAIDS_DISABLED:
+                if(*flag != system.RaidsDisabled())
+                    system.ToggleRaids();
+                break;
+            case EditHistory::RAID_FLEETS:
+                system.RaidFleets() = get<vector<System::RaidFleet>>(field.value);
+                break;
+        }
+    }
+
+    size_t DetailBytes(const EditHistory::DetailValue &value)
+    {
+        size_t size = sizeof(EditHistory::Field);
+        if(const optional<QString> *name = get_if<optional<QString>>(&value))
+            size += (*name ? name->value().size() * sizeof(QChar) : 0);
+        else if(const vector<PeriodicEvent> *events = get_if<vector<PeriodicEvent>>(&value))
+            for(const PeriodicEvent &event : *events)
+                size += sizeof(PeriodicEvent) + event.name.size() * sizeof(QChar);
+        else if(const vector<System::Minable> *minables = get_if<vector<System::Minable>>(&value))
+            for(const System::Minable &minable : *minables)
+                size += sizeof(System::Minable) + minable.type.size() * sizeof(QChar);
+        else if(const vector<System::RaidFleet> *fleets = get_if<vector<System::RaidFleet>>(&value))
+            for(const System::RaidFleet &fleet : *fleets)
+                size += sizeof(System::RaidFleet) + fleet.fleetName.size() * sizeof(QChar);
+        return size;
+    }
+
+    QString Plural(size_t count, const QString &noun)
+    {
+        return QString::number(count) + " " + noun + (count == 1 ? "" : "s");
+    }
+
+    // Describe the seed of a randomized edit, so that it can be reported or
+    // repeated. A seed of zero means the edit was not random.
+    QString SeedText(uint64_t seed)
+    {
+        return seed ? " (seed " + QString::number(seed) + ")" : QString();
+    }
+}
+
+
+
+// Set the memory budget (in bytes) shared by the undo and redo entries.
+void EditHistory::SetBudget(size_t bytes)
+{
+    budget = bytes;
+}
+
+
+
+size_t EditHistory::Budget()
+{
+    return budget;
+}
+
+
+
+void EditHistory::Clear()
+{
+    undo.clear();
+    redo.clear();
+    bytes = 0;
+}
+
+
+
+// Stop merging further edits into the most recent entry.
+void EditHistory::Seal()
+{
+    if(!undo.empty())
+        undo.back().isOpen = false;
+}
+
+
+
+void EditHistory::MoveSystems(const vector<QString> &names, const QVector2D &delta, bool coalesce)
+{
+    if(names.empty())
+        return;
+
+    Entry *open = Open(MOVE_SYSTEMS, names, coalesce);
+    if(open)
+    {
+        get<Move>(open->data).delta += delta;
+        return;
+    }
+
+    Entry entry;
+    entry.kind = MOVE_SYSTEMS;
+    entry.description = (names.size() == 1 ? "Move " + names.front() : "Move " + Plural(names.size(), "system"));
+    entry.names = names;
+    entry.isOpen = coalesce;
+    entry.data = Move{delta};
+    Add(std::move(entry));
+}
+
+
+
+void EditHistory::SetTrade(const QString &commodity, const vector<QString> &names,
+    const vector<int> &before, const vector<int> &after, bool coalesce, uint64_t seed)
+{
+    if(names.empty())
+        return;
+
+    Entry *open = Open(SET_TRADE, names, coalesce);
+    if(open && get<Trade>(open->data).commodity == commodity)
+    {
+        get<Trade>(open->data).after = after;
+        return;
+    }
+
+    Entry entry;
+    entry.kind = SET_TRADE;
+    entry.description = "Set " + commodity + " price"
+        + (names.size() == 1 ? " in " + names.front() : " in " + Plural(names.size(), "system"))
+        + SeedText(seed);
+    entry.names = names;
+    entry.isOpen = coalesce;
+    entry.seed = seed;
+    entry.data = Trade{commodity, before, after};
+    Add(std::move(entry));
+}
+
+
+
+void EditHistory::SetGovernment(const vector<QString> &names, const vector<QString> &before,
+    const QString &after)
+{
+    if(names.empty())
+        return;
+
+    Entry entry;
+    entry.kind = SET_GOVERNMENT;
+    entry.description = "Set government"
+        + (names.size() == 1 ? " of " + names.front() : " of " + Plural(names.size(), "system"));
+    entry.names = names;
+    entry.data = Governments{after, before};
+    Add(std::move(entry));
+}
+
+
+
+void EditHistory::ToggleHidden(const vector<QString> &names)
+{
+    if(names.empty())
+        return;
+
+    Entry entry;
+    entry.kind = TOGGLE_HIDDEN;
+    entry.description = "Toggle hidden" + (names.size() == 1 ? " for " + names.front()
+        : " for " + Plural(names.size(), "system"));
+    entry.names = names;
+    Add(std::move(entry));
+}
+
+
+
+void EditHistory::ToggleLink(const QString &first, const QString &second)
+{
+    Entry entry;
+    entry.kind = TOGGLE_LINK;
+    entry.description = "Toggle link between " + first + " and " + second;
+    entry.names = {first, second};
+    Add(std::move(entry));
+}
+
+
+
+// Record that the object at the given index was dragged, given the orbits of
+// it and every object after it from before the drag.
+void EditHistory::MoveObject(const System &system, int index, const vector<System::Orbit> &before, bool coalesce)
+{
+    vector<QString> names = {system.TrueName()};
+    Entry *open = Open(MOVE_OBJECT, names, coalesce);
+    if(open && get<Orbits>(open->data).index == index)
+    {
+        get<Orbits>(open->data).after = system.Orbits(index);
+        Measure(*open);
+        return;
+    }
+
+    Entry entry;
+    entry.kind = MOVE_OBJECT;
+    entry.description = "Move object in " + system.TrueName();
+    entry.names = names;
+    entry.isOpen = coalesce;
+    entry.data = Orbits{index, before, system.Orbits(index)};
+    Add(std::move(entry));
+}
+
+
+
+// Record an edit that replaced some or all of a system's objects, such as
+// randomizing it, given the objects and habitable zone from before the edit.
+// The objects after the edit are the system's own, so they are not copied.
+void EditHistory::ReplaceObjects(const System &system, vector<StellarObject> before, double habitable,
+    const QString &description, uint64_t seed)
+{
+    Entry entry;
+    entry.kind = REPLACE_OBJECTS;
+    entry.description = description + " " + system.TrueName() + SeedText(seed);
+    entry.names = {system.TrueName()};
+    entry.seed = seed;
+    entry.data = Objects{std::move(before), habitable};
+    Add(std::move(entry));
+}
+
+
+
+// Record an edit that replaced a system's asteroids and minables, given the
+// ones from before the edit.
+void EditHistory::ReplaceAsteroids(const System &system, vector<System::Asteroid> asteroids,
+    vector<System::Minable> minables, vector<System::Belt> belts, const QString &description, uint64_t seed)
+{
+    Entry entry;
+    entry.kind = REPLACE_ASTEROIDS;
+    entry.description = description + " " + system.TrueName() + SeedText(seed);
+    entry.names = {system.TrueName()};
+    entry.seed = seed;
+    entry.data = Asteroids{std::move(asteroids), std::move(minables), std::move(belts)};
+    Add(std::move(entry));
+}
+
+
+
+// Record that the detail view changed some fields of a system, given their
+// values from before the edit.
+void EditHistory::SetDetails(const System &system, vector<Field> before)
+{
+    if(before.empty())
+        return;
+
+    Entry entry;
+    entry.kind = SET_DETAILS;
+    entry.description = (before.size() == 1 ? "Change " + QString(DETAIL_NAMES[before.front().detail])
+        : QString("Change details")) + " of " + system.TrueName();
+    entry.names = {system.TrueName()};
+    entry.data = Details{std::move(before)};
+    Add(std::move(entry));
+}
+
+
+
+void EditHistory::RenameSystem(const QString &from, const QString &to)
+{
+    Entry entry;
+    entry.kind = RENAME_SYSTEM;
+    entry.description = "Rename " + from + " to " + to;
+    entry.names = {from, to};
+    Add(std::move(entry));
+}
+
+
+
+void EditHistory::CreateSystem(const System &system, uint64_t seed)
+{
+    Entry entry;
+    entry.kind = CREATE_SYSTEM;
+    entry.description = "Create " + system.TrueName() + SeedText(seed);
+    entry.names = {system.TrueName()};
+    entry.seed = seed;
+    entry.data = Snapshot{{system}};
+    Add(std::move(entry));
+}
+
+
+
+// Record that a whole batch of systems was created, as a single edit.
+void EditHistory::CreateSystems(const vector<System> &systems, uint64_t seed)
+{
+    if(systems.empty())
+        return;
+
+    Entry entry;
+    entry.kind = CREATE_SYSTEM;
+    entry.description = "Create " + Plural(systems.size(), "system") + SeedText(seed);
+    for(const System &system : systems)
+        entry.names.push_back(system.TrueName());
+    entry.seed = seed;
+    entry.data = Snapshot{systems};
+    Add(std::move(entry));
+}
+
+
+
+// Record that a system is about to be deleted.
+void EditHistory::DeleteSystem(const System &system)
+{
+    Entry entry;
+    entry.kind = DELETE_SYSTEM;
+    entry.description = "Delete " + system.TrueName();
+    entry.names = {system.TrueName()};
+    entry.data = Snapshot{{system}};
+    Add(std::move(entry));
+}
+
+
+
+bool EditHistory::CanUndo() const
+{
+    return !undo.empty();
+}
+
+
+
+bool EditHistory::CanRedo() const
+{
+    return !redo.empty();
+}
+
+
+
+// Describe the edit that would be undone or redone.
+const QString &EditHistory::UndoText() const
+{
+    static const QString EMPTY;
+    return undo.empty() ? EMPTY : undo.back().description;
+}
+
+
+
+const QString &EditHistory::RedoText() const
+{
+    static const QString EMPTY;
+    return redo.empty() ? EMPTY : redo.back().description;
+}
+
+
+
+// Get the seed the edit that would be undone or redone was generated from,
+// or 0 if it was not random.
+uint64_t EditHistory::UndoSeed() const
+{
+    return undo.empty() ? 0 : undo.back().seed;
+}
+
+
+
+uint64_t EditHistory::RedoSeed() const
+{
+    return redo.empty() ? 0 : redo.back().seed;
+}
+
+
+
+// Undo the most recent edit, and return the name of the system it changed (or
+// an empty string if it changed more than one).
+QString EditHistory::Undo(Map &map)
+{
+    if(undo.empty())
+        return QString();
+
+    Entry entry = std::move(undo.back());
+    undo.pop_back();
+    entry.isOpen = false;
+    Apply(map, entry, true);
+    Measure(entry);
+
+    QString name = (entry.names.size() == 1 ? entry.names.front() : QString());
+    if(entry.kind == RENAME_SYSTEM)
+        name = entry.names.front();
+    redo.push_back(std::move(entry));
+    return name;
+}
+
+
+
+QString EditHistory::Redo(Map &map)
+{
+    if(redo.empty())
+        return QString();
+
+    Entry entry = std::move(redo.back());
+    redo.pop_back();
+    Apply(map, entry, false);
+    Measure(entry);
+
+    QString name = (entry.names.size() == 1 ? entry.names.front() : QString());
+    if(entry.kind == RENAME_SYSTEM)
+        name = entry.names.back();
+    undo.push_back(std::move(entry));
+    return name;
+}
+
+
+
+// Get the approximate memory used by all the entries.
+size_t EditHistory::Bytes() const
+{
+    return bytes;
+}
+
+
+
+// Check if the given edit can be merged into the most recent entry.
+EditHistory::Entry *EditHistory::Open(Kind kind, const vector<QString> &names, bool coalesce)
+{
+    if(!coalesce || undo.empty())
+        return nullptr;
+
+    Entry &last = undo.back();
+    if(!last.isOpen || last.kind != kind || last.names != names)
+        return nullptr;
+
+    // Anything that was undone can no longer be redone once a new edit is made.
+    for(const Entry &entry : redo)
+        bytes -= entry.bytes;
+    redo.clear();
+    return &last;
+}
+
+
+
+void EditHistory::Add(Entry &&entry)
+{
+    Seal();
+    for(const Entry &it : redo)
+        bytes -= it.bytes;
+    redo.clear();
+
+    Measure(entry);
+    undo.push_back(std::move(entry));
+    Trim();
+}
+
+
+
+// Undo or redo an edit. An edit that replaced a system's objects or changed
+// its details swaps them with the ones stored in the entry, so the entry
+// changes size.
+void EditHistory::Apply(Map &map, Entry &entry, bool isUndo)
+{
+    auto &systems = map.Systems();
+    auto find = [&systems](const QString &name) -> System *
+    {
+        auto it = systems.find(name);
+        return (it == systems.end() ? nullptr : &it->second);
+    };
+
+    switch(entry.kind)
+    {
+        case MOVE_SYSTEMS:
+        {
+            QVector2D delta = get<Move>(entry.data).delta;
+            for(const QString &name : entry.names)
+                if(System *system = find(name))
+                    system->SetPosition(system->Position() + (isUndo ? -delta : delta));
+            break;
+        }
+        case SET_TRADE:
+        {
+            const Trade &trade = get<Trade>(entry.data);
+            for(unsigned i = 0; i < entry.names.size(); ++i)
+                if(System *system = find(entry.names[i]))
+                    system->SetTrade(trade.commodity, isUndo ? trade.before[i] : trade.after[i]);
+            break;
+        }
+        case SET_GOVERNMENT:
+        {
+            const Governments &governments = get<Governments>(entry.data);
+            for(unsigned i = 0; i < entry.names.size(); ++i)
+                if(System *system = find(entry.names[i]))
+                    system->SetGovernment(isUndo ? governments.before[i] : governments.after);
+            break;
+        }
+        case TOGGLE_HIDDEN:
+            for(const QString &name : entry.names)
+                if(System *system = find(name))
+                    system->ToggleHidden();
+            break;
+        case TOGGLE_LINK:
+            if(System *system = find(entry.names.front()))
+                system->ToggleLink(find(entry.names.back()));
+            break;
+        case MOVE_OBJECT:
+            if(System *system = find(entry.names.front()))
+            {
+                const Orbits &orbits = get<Orbits>(entry.data);
+                system->SetOrbits(orbits.index, isUndo ? orbits.before : orbits.after);
+            }
+            break;
+        case REPLACE_OBJECTS:
+            if(System *system = find(entry.names.front()))
+            {
+                Objects &stored = get<Objects>(entry.data);
+                vector<StellarObject> current = system->Objects();
+                double habitable = system->HabitableZone();
+                system->SetObjects(stored.objects, stored.habitable);
+                stored.objects = std::move(current);
+                stored.habitable = habitable;
+            }
+            break;
+        case REPLACE_ASTEROIDS:
+            if(System *system = find(entry.names.front()))
+            {
+                Asteroids &stored = get<Asteroids>(entry.data);
+                Asteroids current = {system->Asteroids(), system->Minables(), system->Belts()};
+                system->SetAsteroids(stored.asteroids, stored.minables, stored.belts);
+                stored = std::move(current);
+            }
+            break;
+        case SET_DETAILS:
+            if(System *system = find(entry.names.front()))
+                for(Field &field : get<Details>(entry.data).fields)
+                {
+                    DetailValue current = GetDetail(*system, field.detail);
+                    SetDetail(*system, field);
+                    field.value = std::move(current);
+                }
+            break;
+        case RENAME_SYSTEM:
+            if(isUndo)
+                map.RenameSystem(entry.names.back(), entry.names.front());
+            else
+                map.RenameSystem(entry.names.front(), entry.names.back());
+            break;
+        case CREATE_SYSTEM:
+        case DELETE_SYSTEM:
+            if(isUndo == (entry.kind == CREATE_SYSTEM))
+                for(const QString &name : entry.names)
+                    map.DeleteSystem(name);
+            else
+                for(const System &system : get<Snapshot>(entry.data).systems)
+                    map.InsertSystem(system);
+            break;
+    }
+}
+
+
+
+void EditHistory::Measure(Entry &entry)
+{
+    size_t size = sizeof(Entry) + StringBytes(entry.description);
+    for(const QString &name : entry.names)
+        size += StringBytes(name);
+    if(const Trade *trade = get_if<Trade>(&entry.data))
+        size += StringBytes(trade->commodity) + (trade->before.size() + trade->after.size()) * sizeof(int);
+    else if(const Governments *governments = get_if<Governments>(&entry.data))
+    {
+        size += StringBytes(governments->after);
+        for(const QString &text : governments->before)
+            size += StringBytes(text);
+    }
+    else if(const Orbits *orbits = get_if<Orbits>(&entry.data))
+        size += (orbits->before.size() + orbits->after.size()) * sizeof(System::Orbit);
+    else if(const Objects *objects = get_if<Objects>(&entry.data))
+        size += ObjectBytes(objects->objects);
+    else if(const Asteroids *asteroids = get_if<Asteroids>(&entry.data))
+    {
+        for(const System::Asteroid &asteroid : asteroids->asteroids)
+            size += sizeof(System::Asteroid) + asteroid.type.size() * sizeof(QChar);
+        for(const System::Minable &minable : asteroids->minables)
+            size += sizeof(System::Minable) + minable.type.size() * sizeof(QChar);
+        size += asteroids->belts.size() * sizeof(System::Belt);
+    }
+    else if(const Details *details = get_if<Details>(&entry.data))
+        for(const Field &field : details->fields)
+            size += DetailBytes(field.value);
+    else if(const Snapshot *snapshot = get_if<Snapshot>(&entry.data))
+        for(const System &system : snapshot->systems)
+            size += sizeof(System) + ObjectBytes(system.Objects());
+
+    bytes += size - entry.bytes;
+    entry.bytes = size;
+}
+
+
+
+// Drop the oldest entries until everything fits in the budget. The most recent
+// edit is always kept, even if it alone is over the budget.
+void EditHistory::Trim()
+{
+    while(bytes > budget && undo.size() > 1)
+    {
+        bytes -= undo.front().bytes;
+        undo.pop_front();
+    }
+}
@@ -0,0 +1,216 @@
+/* EditHistory.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef EDITHISTORY_H_
+#define EDITHISTORY_H_
+
+#include "PeriodicEvent.h"
+#include "StellarObject.h"
+#include "System.h"
+
+#include <QString>
+#include <QVector2D>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <variant>
+#include <vector>
+
+class Map;
+
+
+
+// Class for undoing and redoing edits to the map. Each edit is recorded after
+// it has been made, as just enough information to reverse it (e.g. a move of a
+// group of systems is a list of names and one offset, and a price change is the
+// old and new prices), rather than as a copy of the systems involved. Each kind
+// of edit only stores the data it needs. An edit that replaces a system's
+// objects keeps only the version of them the system does not have, and so
+// does an edit to one of the fields in the detail view. Whole
+// systems are only stored when one is created or deleted. A continuous change,
+// like dragging a system, is merged into a single entry until Seal() is called.
+// Once the entries take up more memory than the budget, the oldest are dropped.
+class EditHistory {
+public:
+    enum Kind {
+        MOVE_SYSTEMS,
+        SET_TRADE,
+        SET_GOVERNMENT,
+        TOGGLE_HIDDEN,
+        TOGGLE_LINK,
+        MOVE_OBJECT,
+        REPLACE_OBJECTS,
+        REPLACE_ASTEROIDS,
+        SET_DETAILS,
+        RENAME_SYSTEM,
+        CREATE_SYSTEM,
+        DELETE_SYSTEM
+    };
+    // The fields of a system that the detail view edits one at a time.
+    enum Detail {
+        DISPLAY_NAME,
+        SHROUDED,
+        INACCESSIBLE,
+        JUMP_RANGE,
+        HYPER_ARRIVAL,
+        JUMP_ARRIVAL,
+        HYPER_DEPARTURE,
+        JUMP_DEPARTURE,
+        RAMSCOOP_UNIVERSAL,
+        RAMSCOOP_ADDEND,
+        RAMSCOOP_MULTIPLIER,
+        FLEETS,
+        MINABLES,
+        HAZARDS,
+        RAIDS_DISABLED,
+        RAID_FLEETS
+    };
+    // The value of one of those fields. The display name has no value if the
+    // system does not have one.
+    using DetailValue = std::variant<bool, double, std::optional<QString>, std::vector<PeriodicEvent>,
+        std::vector<System::Minable>, std::vector<System::RaidFleet>>;
+    struct Field {
+        Detail detail;
+        DetailValue value;
+    };
+
+
+public:
+    // Set the memory budget (in bytes) shared by the undo and redo entries.
+    static void SetBudget(size_t bytes);
+    static size_t Budget();
+
+    void Clear();
+    // Stop merging further edits into the most recent entry.
+    void Seal();
+
+    // Record edits that have just been made. If "coalesce" is set and the most
+    // recent entry is an unsealed edit of the same kind to the same systems,
+    // it is extended instead of adding a new entry. Randomized edits also
+    // record the seed they were generated from.
+    void MoveSystems(const std::vector<QString> &names, const QVector2D &delta, bool coalesce);
+    void SetTrade(const QString &commodity, const std::vector<QString> &names,
+        const std::vector<int> &before, const std::vector<int> &after, bool coalesce = false, uint64_t seed = 0);
+    void SetGovernment(const std::vector<QString> &names, const std::vector<QString> &before,
+        const QString &after);
+    void ToggleHidden(const std::vector<QString> &names);
+    void ToggleLink(const QString &first, const QString &second);
+    void MoveObject(const System &system, int index, const std::vector<System::Orbit> &before, bool coalesce);
+    void ReplaceObjects(const System &system, std::vector<StellarObject> before, double habitable,
+        const QString &description, uint64_t seed = 0);
+    // Record an edit that replaced a system's asteroids and minables, given
+    // the ones from before the edit.
+    void ReplaceAsteroids(const System &system, std::vector<System::Asteroid> asteroids,
+        std::vector<System::Minable> minables, std::vector<System::Belt> belts, const QString &description,
+        uint64_t seed);
+    // Record that the detail view changed some fields of a system, given their
+    // values from before the edit.
+    void SetDetails(const System &system, std::vector<Field> before);
+    void RenameSystem(const QString &from, const QString &to);
+    void CreateSystem(const System &system, uint64_t seed = 0);
+    // Record that a whole batch of systems was created, as a single edit.
+    void CreateSystems(const std::vector<System> &systems, uint64_t seed = 0);
+    void DeleteSystem(const System &system);
+
+    bool CanUndo() const;
+    bool CanRedo() const;
+    // Describe the edit that would be undone or redone.
+    const QString &UndoText() const;
+    const QString &RedoText() const;
+    // Get the seed the edit that would be undone or redone was generated from,
+    // or 0 if it was not random.
+    uint64_t UndoSeed() const;
+    uint64_t RedoSeed() const;
+    // Undo or redo the most recent edit, and return the name of the system it
+    // changed (or an empty string if it changed more than one).
+    QString Undo(Map &map);
+    QString Redo(Map &map);
+
+    // Get the approximate memory used by all the entries.
+    size_t Bytes() const;
+
+
+private:
+    // The data each kind of edit needs, beyond the names of its systems.
+    struct Move {
+        QVector2D delta;
+    };
+    struct Trade {
+        QString commodity;
+        std::vector<int> before;
+        std::vector<int> after;
+    };
+    struct Governments {
+        QString after;
+        std::vector<QString> before;
+    };
+    struct Orbits {
+        int index = 0;
+        std::vector<System::Orbit> before;
+        std::vector<System::Orbit> after;
+    };
+    // Whichever version of the objects the system does not have right now.
+    // Undoing or redoing the edit swaps them with the system's objects.
+    struct Objects {
+        std::vector<StellarObject> objects;
+        double habitable = 0.;
+    };
+    // The same, for the asteroids, minables, and belts.
+    struct Asteroids {
+        std::vector<System::Asteroid> asteroids;
+        std::vector<System::Minable> minables;
+        std::vector<System::Belt> belts;
+    };
+    // The same, for the fields changed in the detail view.
+    struct Details {
+        std::vector<Field> fields;
+    };
+    // The systems that were created or deleted.
+    struct Snapshot {
+        std::vector<System> systems;
+    };
+
+    struct Entry {
+        Kind kind;
+        QString description;
+        // The systems this edit applies to.
+        std::vector<QString> names;
+        bool isOpen = false;
+        size_t bytes = 0;
+        // The seed a randomized edit was generated from, or 0.
+        uint64_t seed = 0;
+        // Toggles and renames need nothing but the names.
+        std::variant<std::monostate, Move, Trade, Governments, Orbits, Objects, Asteroids, Details,
+            Snapshot> data;
+    };
+
+
+private:
+    // Check if the given edit can be merged into the most recent entry.
+    Entry *Open(Kind kind, const std::vector<QString> &names, bool coalesce);
+    void Add(Entry &&entry);
+    void Apply(Map &map, Entry &entry, bool isUndo);
+    void Measure(Entry &entry);
+    void Trim();
+
+
+private:
+    std::deque<Entry> undo;
+    std::vector<Entry> redo;
+    size_t bytes = 0;
+};
+
+
+
+#endif
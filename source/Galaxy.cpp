@@ -65,6 +65,19 @@ void Galaxy::Save(DataWriter &file) const
 
 
 
+// Get the hash of the data node this galaxy is saved as, like System::Hash().
+uint64_t Galaxy::Hash() const
+{
+    uint64_t hash = DataNode::EMPTY_HASH;
+    {
+        DataWriter file(&hash);
+        Save(file);
+    }
+    return hash;
+}
+
+
+
 const QVector2D &Galaxy::Position() const
 {
     return position;
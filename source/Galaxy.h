@@ -16,6 +16,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <QVector2D>
 #include <QString>
 
+#include <cstdint>
 #include <list>
 
 class DataNode;
@@ -30,6 +31,8 @@ public:
 
     void Load(const DataNode &node);
     void Save(DataWriter &file) const;
+    // Get the hash of the data node this galaxy is saved as, like System::Hash().
+    uint64_t Hash() const;
 
     const QVector2D &Position() const;
     const QString &Sprite() const;
@@ -0,0 +1,335 @@
+/* GalaxyRenderer.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "GalaxyRenderer.h"
+
+#include "Map.h"
+#include "PaintProfiler.h"
+#include "ParallelFor.h"
+#include "SpriteSet.h"
+#include "System.h"
+
+#include <QPainter>
+#include <QPixmap>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+    // Large images are split into square tiles of this size, which are drawn
+    // in parallel. Each tile paints straight into its part of the final image.
+    const int TILE_SIZE = 1024;
+    // Leave room around the systems for their names and the selection ring.
+    const double MARGIN = 110.;
+
+    QColor MapGrey(double value)
+    {
+        value = max(0., min(1., (value + 1.) / 2.));
+        return QColor(
+            200. * value + 55.9,
+            200. * value + 55.9,
+            200. * value + 55.9);
+    }
+}
+
+
+
+GalaxyRenderer::GalaxyRenderer(const Map &mapData)
+    : mapData(mapData), heatmap(mapData)
+{
+}
+
+
+
+// Map a value between -1 and 1 to a color.
+QColor GalaxyRenderer::MapColor(double value)
+{
+    value = min(1., max(-1., value));
+    if(value < 0.)
+        return QColor(
+            (.12 + .12 * value) * 255.9,
+            (.48 + .36 * value) * 255.9,
+            (.48 - .12 * value) * 255.9);
+    else
+        return QColor(
+            (.12 + .48 * value) * 255.9,
+            (.48 + .00 * value) * 255.9,
+            (.48 - .48 * value) * 255.9);
+}
+
+
+
+// Color the map by a commodity or a government (which clears the other).
+void GalaxyRenderer::SetCommodity(const QString &name)
+{
+    commodity = name;
+    government.clear();
+}
+
+
+
+void GalaxyRenderer::SetGovernment(const QString &name)
+{
+    government = name;
+    commodity.clear();
+}
+
+
+
+const QString &GalaxyRenderer::Commodity() const
+{
+    return commodity;
+}
+
+
+
+const QString &GalaxyRenderer::Government() const
+{
+    return government;
+}
+
+
+
+void GalaxyRenderer::SetSelected(const System *system)
+{
+    selected = system;
+}
+
+
+
+// Highlight the systems with the given names (which must outlive this).
+void GalaxyRenderer::SetSelection(const set<QString> *names)
+{
+    selection = names;
+}
+
+
+
+// Show the price heatmap when coloring by a commodity.
+void GalaxyRenderer::SetHeatmap(bool show)
+{
+    showHeatmap = show;
+    if(!show)
+        heatmap.Clear();
+}
+
+
+
+bool GalaxyRenderer::HasHeatmap() const
+{
+    return showHeatmap;
+}
+
+
+
+// Draw the map with the given painter, which must already be transformed
+// so that it maps galaxy coordinates onto its device.
+void GalaxyRenderer::Draw(QPainter &painter, PaintProfiler *profiler)
+{
+    UpdateHeatmap(profiler);
+    Draw(painter, profiler, nullptr);
+}
+
+
+
+// Get the region, in galaxy coordinates, that contains everything drawn.
+QRectF GalaxyRenderer::Bounds() const
+{
+    QRectF bounds;
+    for(const Galaxy &it : mapData.Galaxies())
+    {
+        QPixmap sprite = SpriteSet::Get(it.Sprite());
+        QPointF pos = (it.Position() - QVector2D(.5 * sprite.width(), .5 * sprite.height())).toPointF();
+        bounds |= QRectF(pos, QSizeF(sprite.width(), sprite.height()));
+    }
+    for(const auto &it : mapData.Systems())
+    {
+        QPointF pos = it.second.Position().toPointF();
+        bounds |= QRectF(pos - QPointF(MARGIN, MARGIN), pos + QPointF(MARGIN, MARGIN));
+    }
+    return bounds;
+}
+
+
+
+// Render the given region of the galaxy into an image, at the given scale.
+QImage GalaxyRenderer::Render(const QRectF &region, double scale)
+{
+    int width = ceil(region.width() * scale);
+    int height = ceil(region.height() * scale);
+    QImage image(max(1, width), max(1, height), QImage::Format_ARGB32_Premultiplied);
+    if(image.isNull())
+        return image;
+
+    // QPixmaps can only be used in the GUI thread, so convert the galaxy
+    // sprites to images before starting any of the workers.
+    map<QString, QImage> images;
+    for(const Galaxy &it : mapData.Galaxies())
+        if(!images.count(it.Sprite()))
+            images[it.Sprite()] = SpriteSet::Get(it.Sprite()).toImage();
+    UpdateHeatmap(nullptr);
+
+    // Each tile is a view into the final image's pixels, so no copying or
+    // stitching is needed once the workers are done.
+    uchar *bits = image.bits();
+    qsizetype stride = image.bytesPerLine();
+    int columns = (image.width() + TILE_SIZE - 1) / TILE_SIZE;
+    int rows = (image.height() + TILE_SIZE - 1) / TILE_SIZE;
+    ParallelFor(columns * rows, [&](int i)
+    {
+        int x = (i % columns) * TILE_SIZE;
+        int y = (i / columns) * TILE_SIZE;
+        QImage tile(bits + y * stride + x * 4,
+            min(TILE_SIZE, image.width() - x), min(TILE_SIZE, image.height() - y),
+            stride, image.format());
+        tile.fill(Qt::black);
+
+        QPainter painter(&tile);
+        painter.setRenderHint(QPainter::Antialiasing, true);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter.translate(-x, -y);
+        painter.scale(scale, scale);
+        painter.translate(-region.left(), -region.top());
+        Draw(painter, nullptr, &images);
+    });
+    return image;
+}
+
+
+
+// Recompute any part of the heatmap that is out of date.
+void GalaxyRenderer::UpdateHeatmap(PaintProfiler *profiler)
+{
+    if(!showHeatmap || commodity.isEmpty())
+        return;
+
+    bool changed = heatmap.Update(commodity);
+    if(profiler)
+        profiler->Cache(!changed);
+}
+
+
+
+// Draw the map using the given images for the galaxy sprites, instead of
+// the SpriteSet pixmaps (which may only be used in the GUI thread).
+void GalaxyRenderer::Draw(QPainter &painter, PaintProfiler *profiler, const map<QString, QImage> *images) const
+{
+    QPen blackPen;
+    QPen mediumPen(QColor(120, 120, 120));
+    QPen brightPen(QColor(180, 180, 180));
+
+    // Draw the "galaxy" images.
+    for(const Galaxy &it : mapData.Galaxies())
+    {
+        if(images)
+        {
+            auto iit = images->find(it.Sprite());
+            if(iit == images->end())
+                continue;
+            const QImage &sprite = iit->second;
+            QPointF pos = (it.Position() - QVector2D(.5 * sprite.width(), .5 * sprite.height())).toPointF();
+            painter.drawImage(pos, sprite);
+        }
+        else
+        {
+            QPixmap sprite = SpriteSet::Get(it.Sprite());
+            QPointF pos = (it.Position() - QVector2D(.5 * sprite.width(), .5 * sprite.height())).toPointF();
+            painter.drawPixmap(pos, sprite);
+        }
+        if(profiler)
+            profiler->Count(PaintProfiler::SPRITES);
+    }
+
+    // Draw the price heatmap, stretching each grid cell to cover its part of
+    // the map. The smooth transform blends the cells into a continuous field.
+    if(showHeatmap && !commodity.isEmpty() && !heatmap.Image().isNull())
+        painter.drawImage(heatmap.Bounds(), heatmap.Image());
+
+    // Draw the links between systems.
+    painter.setBrush(Qt::NoBrush);
+    for(const auto &it : mapData.Systems())
+    {
+        QPointF pos = it.second.Position().toPointF();
+        for(const QString &link : it.second.Links())
+        {
+            auto lit = mapData.Systems().find(link);
+            if(lit == mapData.Systems().end())
+                continue;
+
+            double value = 0.;
+            if(!commodity.isEmpty())
+            {
+                int difference = abs(it.second.Trade(commodity) - lit->second.Trade(commodity));
+                value = (difference - 60) / 60.;
+            }
+            else if(!government.isEmpty())
+                value = (it.second.Government() != lit->second.Government());
+            // Set the link color based on the "value".
+            QPen pen(value < 1. ? MapGrey(value) : QColor(255, 0, 0));
+            painter.setPen(pen);
+            painter.drawLine(pos, lit->second.Position().toPointF());
+            if(profiler)
+                profiler->Count(PaintProfiler::LINKS);
+        }
+    }
+
+    // Draw the systems, colored by commodity or if the government is the selected government.
+    for(const auto &it : mapData.Systems())
+    {
+        QPointF pos = it.second.Position().toPointF();
+        bool isSelected = (&it.second == selected);
+        double value = 0.;
+        if(!commodity.isEmpty())
+            value = mapData.MapPrice(commodity, it.second.Trade(commodity)) * 2. - 1.;
+        else if(!government.isEmpty())
+            value = (it.second.Government() == government);
+        // Set the link color based on the "value".
+        QColor color = MapColor(value);
+        if(isSelected)
+            color.setRgbF(color.redF() * 1.5, color.greenF() * 1.5, color.blueF() * 1.5);
+        QBrush brush(color);
+        painter.setBrush(brush);
+        painter.setPen(blackPen);
+        painter.drawEllipse(pos, 5, 5);
+
+        painter.drawText(pos + QPointF(6, 6), it.first);
+        painter.setPen(brightPen);
+        painter.drawText(pos + QPointF(5, 5), it.first);
+        if(profiler)
+            profiler->Count(PaintProfiler::SYSTEMS);
+    }
+
+    // Draw a ring around each system in the group selection.
+    painter.setBrush(Qt::NoBrush);
+    if(selection && !selection->empty())
+    {
+        painter.setPen(QPen(QColor(255, 200, 0), 1.5));
+        for(const QString &name : *selection)
+        {
+            auto it = mapData.Systems().find(name);
+            if(it != mapData.Systems().end())
+                painter.drawEllipse(it->second.Position().toPointF(), 8, 8);
+        }
+    }
+
+    // Draw the selection circle and neighbor radius ring.
+    painter.setPen(mediumPen);
+    if(selected)
+    {
+        QPointF pos = selected->Position().toPointF();
+        painter.drawEllipse(pos, 10, 10);
+        painter.drawEllipse(pos, 100, 100);
+    }
+}
@@ -0,0 +1,90 @@
+/* GalaxyRenderer.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef GALAXYRENDERER_H
+#define GALAXYRENDERER_H
+
+#include "TradeHeatmap.h"
+
+#include <QColor>
+#include <QImage>
+#include <QRectF>
+#include <QString>
+
+#include <map>
+#include <set>
+
+class Map;
+class PaintProfiler;
+class System;
+
+class QPainter;
+
+
+
+// Class for drawing the galaxy map: the galaxy images, the hyperspace links and
+// the systems, optionally colored by a commodity (with a heatmap of its price
+// underneath) or by a government. The same drawing is used by the GalaxyView
+// widget and for rendering the map to an image, which splits large images into
+// tiles that are drawn in parallel.
+class GalaxyRenderer {
+public:
+    explicit GalaxyRenderer(const Map &mapData);
+
+    // Map a value between -1 and 1 to a color.
+    static QColor MapColor(double value);
+
+    // Color the map by a commodity or a government (which clears the other).
+    void SetCommodity(const QString &name);
+    void SetGovernment(const QString &name);
+    const QString &Commodity() const;
+    const QString &Government() const;
+    void SetSelected(const System *system);
+    // Highlight the systems with the given names (which must outlive this).
+    void SetSelection(const std::set<QString> *names);
+    // Show the price heatmap when coloring by a commodity.
+    void SetHeatmap(bool show);
+    bool HasHeatmap() const;
+
+    // Draw the map with the given painter, which must already be transformed
+    // so that it maps galaxy coordinates onto its device.
+    void Draw(QPainter &painter, PaintProfiler *profiler = nullptr);
+
+    // Get the region, in galaxy coordinates, that contains everything drawn.
+    QRectF Bounds() const;
+    // Render the given region of the galaxy into an image, at the given scale.
+    QImage Render(const QRectF &region, double scale);
+
+
+private:
+    // Recompute any part of the heatmap that is out of date.
+    void UpdateHeatmap(PaintProfiler *profiler);
+    // Draw the map using the given images for the galaxy sprites, instead of
+    // the SpriteSet pixmaps (which may only be used in the GUI thread).
+    void Draw(QPainter &painter, PaintProfiler *profiler, const std::map<QString, QImage> *images) const;
+
+
+private:
+    const Map &mapData;
+
+    QString commodity;
+    QString government;
+    const System *selected = nullptr;
+    const std::set<QString> *selection = nullptr;
+
+    bool showHeatmap = false;
+    TradeHeatmap heatmap;
+};
+
+
+
+#endif // GALAXYRENDERER_H
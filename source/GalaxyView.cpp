@@ -14,13 +14,18 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "DetailView.h"
 #include "Map.h"
-#include "SpriteSet.h"
+#include "MapQuery.h"
+#include "OrbitValidator.h"
+#include "Random.h"
+#include "RegionGenerator.h"
 #include "SystemView.h"
 
 #include <QInputDialog>
+#include <QLineEdit>
 #include <QMessageBox>
 #include <QPainter>
 #include <QPalette>
+#include <QPolygonF>
 #include <QMouseEvent>
 #include <QTabWidget>
 #include <QVector2D>
@@ -34,35 +39,15 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 using namespace std;
 
 namespace {
-    // Map a value between -1 and 1 to a color.
-    QColor MapColor(double value)
-    {
-        value = min(1., max(-1., value));
-        if(value < 0.)
-            return QColor(
-                (.12 + .12 * value) * 255.9,
-                (.48 + .36 * value) * 255.9,
-                (.48 - .12 * value) * 255.9);
-        else
-            return QColor(
-                (.12 + .48 * value) * 255.9,
-                (.48 + .00 * value) * 255.9,
-                (.48 - .48 * value) * 255.9);
-    }
-    QColor MapGrey(double value)
-    {
-        value = max(0., min(1., (value + 1.) / 2.));
-        return QColor(
-            200. * value + 55.9,
-            200. * value + 55.9,
-            200. * value + 55.9);
-    }
+    const int MAX_REGION_SYSTEMS = 100000;
+    // At most this many spacing errors are listed in the report.
+    const int MAX_LISTED_ERRORS = 20;
 }
 
 
 
 GalaxyView::GalaxyView(Map &mapData, QTabWidget *tabs, QWidget *parent) :
-    QWidget(parent), mapData(mapData), tabs(tabs)
+    QWidget(parent), mapData(mapData), tabs(tabs), renderer(mapData), profiler("Galaxy")
 {
     setAutoFillBackground(true);
     QPalette p = palette();
@@ -70,7 +55,10 @@ GalaxyView::GalaxyView(Map &mapData, QTabWidget *tabs, QWidget *parent) :
     setPalette(p);
     setToolTip("Left click to select a system. Drag to move a system or pan the view.\n"
         "Right click to create a new system or to toggle links between systems.\n"
+        "Shift+drag to select a rectangle, or Ctrl+drag to draw a lasso around systems.\n"
+        "Shift+click to add or remove a system. Drag a selected system to move them all.\n"
         "Use the scroll wheel to zoom in and out.");
+    renderer.SetSelection(&selection);
 
     Center();
 }
@@ -108,10 +96,9 @@ void GalaxyView::SetDetailView(DetailView *view)
 // Color the map by this commodity.
 void GalaxyView::SetCommodity(const QString &name)
 {
-    if(commodity != name)
+    if(renderer.Commodity() != name)
     {
-        commodity = name;
-        government.clear();
+        renderer.SetCommodity(name);
         update();
     }
 }
@@ -121,10 +108,9 @@ void GalaxyView::SetCommodity(const QString &name)
 // Color the map by this government.
 void GalaxyView::SetGovernment(const QString &name)
 {
-    if(government != name)
+    if(renderer.Government() != name)
     {
-        government = name;
-        commodity.clear();
+        renderer.SetGovernment(name);
         update();
     }
 }
@@ -139,6 +125,14 @@ void GalaxyView::KeyPress(QKeyEvent *event)
 
 
 
+// Get the names of the systems in the group selection.
+const set<QString> &GalaxyView::Selection() const
+{
+    return selection;
+}
+
+
+
 // Create a system at (0, 0).
 void GalaxyView::CreateSystem()
 {
@@ -151,6 +145,46 @@ void GalaxyView::CreateSystem()
 
 
 
+// Fill the last rubber band or lasso (or the visible part of the map, if there
+// is none) with new systems, and select them.
+void GalaxyView::GenerateRegion()
+{
+    QPolygonF area = region;
+    if(area.size() < 3 || area.boundingRect().isEmpty())
+        area = QPolygonF(QRectF(MapPoint(QPoint(0, 0)).toPointF(), MapPoint(QPoint(width(), height())).toPointF()));
+
+    bool ok = false;
+    int count = QInputDialog::getInt(this, "Generate region", "Number of systems:",
+        100, 1, MAX_REGION_SYSTEMS, 1, &ok);
+    if(!ok)
+        return;
+    QString prefix = QInputDialog::getText(this, "Generate region", "Name prefix:",
+        QLineEdit::Normal, "Region", &ok);
+    if(!ok || prefix.isEmpty())
+        return;
+
+    uint64_t seed = Random::NewSeed();
+    vector<System> systems = RegionGenerator(area, seed).Generate(mapData, count, prefix);
+    if(systems.empty())
+        return;
+
+    selection.clear();
+    for(const System &system : systems)
+    {
+        mapData.InsertSystem(system);
+        selection.insert(system.TrueName());
+    }
+    mapData.History().CreateSystems(systems, seed);
+    mapData.SetChanged();
+    update();
+
+    if(static_cast<int>(systems.size()) < count)
+        QMessageBox::information(this, "Region full", "Only " + QString::number(systems.size())
+            + " of the " + QString::number(count) + " systems fit in this region.");
+}
+
+
+
 // Change the name of a system, which involves creating a new pointer
 // and updating the system and detail views with it.
 bool GalaxyView::RenameSystem(const QString &from, const QString &to)
@@ -181,7 +215,10 @@ bool GalaxyView::RenameSystem(const QString &from, const QString &to)
     else
     {
         mapData.RenameSystem(from, to);
+        mapData.History().RenameSystem(from, to);
         mapData.SetChanged();
+        if(selection.erase(from))
+            selection.insert(to);
 
         // Update the system pointed to by the two views, as the old pointer is invalid.
         System *newSystem = &mapData.Systems()[to];
@@ -212,20 +249,10 @@ void GalaxyView::DeleteSystem()
     {
         // Deselect this system.
         systemView->Select(nullptr);
-        // Remove all links from this system (and the corresponding return links, if able).
-        while(!system->Links().empty())
-        {
-            // The system to be deleted may have a link to a "plugin" system.
-            auto it = mapData.Systems().find(*system->Links().begin());
-            if(it != mapData.Systems().end())
-                system->ToggleLink(&it->second);
-            // Only this system's endpoint can be modified.
-            else
-                system->ChangeLink(*system->Links().begin(), QString());
-        }
-
         // Remove this system from known systems.
-        mapData.Systems().erase(system->TrueName());
+        selection.erase(system->TrueName());
+        mapData.History().DeleteSystem(*system);
+        mapData.DeleteSystem(system->TrueName());
         mapData.SetChanged();
     }
     update();
@@ -244,10 +271,12 @@ void GalaxyView::Recenter()
 void GalaxyView::RandomizeCommodity()
 {
     // Randomize the values of the currently selected commodity.
+    const QString &commodity = renderer.Commodity();
 
     // First, make sure a system and a commodity are selected.
     if(commodity.isEmpty() || !systemView || !systemView->Selected())
         return;
+    Random random(Random::NewSeed());
 
     // Next, find all the systems connected via hyperlinks to the current system.
     set<System *> connected;
@@ -323,7 +352,7 @@ void GalaxyView::RandomizeCommodity()
 
         while(!unassigned.empty())
         {
-            int i = rand() % unassigned.size();
+            int i = random.Int(unassigned.size());
             const System *system = unassigned[i];
             unassigned[i] = unassigned.back();
             unassigned.pop_back();
@@ -336,7 +365,7 @@ void GalaxyView::RandomizeCommodity()
                 break;
 
             // Pick a random one of those items to assign to it.
-            int index = rand() % possibilities;
+            int index = random.Int(possibilities);
             int choice = low[system];
             while(true)
             {
@@ -397,10 +426,13 @@ void GalaxyView::RandomizeCommodity()
     // Assign each star system a value based on its bin.
     map<const System *, int> rough;
     for(const auto &it : bin)
-        rough[it.first] = base + (rand() % 100) + 100 * it.second;
+        rough[it.first] = base + random.Int(100) + 100 * it.second;
 
     // Smooth out the values by averaging each system with the average of all
     // its neighbors.
+    vector<QString> names;
+    vector<int> before;
+    vector<int> after;
     for(System *system : connected)
     {
         int count = 0;
@@ -419,9 +451,13 @@ void GalaxyView::RandomizeCommodity()
             sum += count * rough[system];
             sum = (sum + count) / (2 * count);
         }
+        names.push_back(system->TrueName());
+        before.push_back(system->Trade(commodity));
+        after.push_back(sum);
         system->SetTrade(commodity, sum);
     }
-    mapData.SetChanged();
+    mapData.History().SetTrade(commodity, names, before, after, false, random.Seed());
+    mapData.SetChanged(true, Map::TRADE);
     if(detailView)
         detailView->UpdateCommodities();
     update();
@@ -429,8 +465,114 @@ void GalaxyView::RandomizeCommodity()
 
 
 
+// Show or hide the heatmap of the selected commodity's price.
+void GalaxyView::ToggleHeatmap()
+{
+    renderer.SetHeatmap(!renderer.HasHeatmap());
+    update();
+}
+
+
+
+void GalaxyView::SelectNone()
+{
+    if(!selection.empty())
+    {
+        selection.clear();
+        update();
+    }
+}
+
+
+
+void GalaxyView::SetSelectionGovernment()
+{
+    if(selection.empty())
+        return;
+
+    QString current = (systemView && systemView->Selected()) ? systemView->Selected()->Government() : QString();
+    bool ok = false;
+    QString newGov = QInputDialog::getText(this, "Set government",
+        "Government of the " + QString::number(selection.size()) + " selected systems:",
+        QLineEdit::Normal, current, &ok);
+    if(!ok || newGov.isEmpty())
+        return;
+
+    vector<QString> names;
+    vector<QString> before;
+    EditSelection(Map::GOVERNMENTS, [&](System &system)
+    {
+        names.push_back(system.TrueName());
+        before.push_back(system.Government());
+        system.SetGovernment(newGov);
+    });
+    mapData.History().SetGovernment(names, before, newGov);
+}
+
+
+
+// Set the price of the commodity the map is colored by.
+void GalaxyView::SetSelectionTrade()
+{
+    const QString &commodity = renderer.Commodity();
+    if(selection.empty() || commodity.isEmpty())
+        return;
+
+    int current = 0;
+    for(const Map::Commodity &it : mapData.Commodities())
+        if(it.name == commodity)
+            current = (it.low + it.high) / 2;
+    if(systemView && systemView->Selected())
+        current = systemView->Selected()->Trade(commodity);
+    bool ok = false;
+    int price = QInputDialog::getInt(this, "Set price",
+        commodity + " price in the " + QString::number(selection.size()) + " selected systems:",
+        current, 0, 100000, 10, &ok);
+    if(!ok)
+        return;
+
+    vector<QString> names;
+    vector<int> before;
+    EditSelection(Map::TRADE, [&](System &system)
+    {
+        names.push_back(system.TrueName());
+        before.push_back(system.Trade(commodity));
+        system.SetTrade(commodity, price);
+    });
+    mapData.History().SetTrade(commodity, names, before, vector<int>(names.size(), price));
+}
+
+
+
+// If any selected system is visible, hide them all. Otherwise, show them all.
+void GalaxyView::ToggleSelectionHidden()
+{
+    bool hide = false;
+    for(const QString &name : selection)
+    {
+        auto it = mapData.Systems().find(name);
+        if(it != mapData.Systems().end())
+            hide |= !it->second.Hidden();
+    }
+
+    vector<QString> names;
+    EditSelection(Map::DETAILS, [&](System &system)
+    {
+        if(system.Hidden() != hide)
+        {
+            names.push_back(system.TrueName());
+            system.ToggleHidden();
+        }
+    });
+    mapData.History().ToggleHidden(names);
+}
+
+
+
 void GalaxyView::mousePressEvent(QMouseEvent *event)
 {
+    // Each click starts a new edit, rather than continuing the last drag.
+    mapData.History().Seal();
     clickOff = QVector2D(event->pos()) - offset;
 
     dragSystem = nullptr;
@@ -444,7 +586,16 @@ void GalaxyView::mousePressEvent(QMouseEvent *event)
 
     if(!dragSystem)
     {
-        if(event->button() == Qt::RightButton)
+        // Shift+drag selects a rectangle, and Ctrl+drag draws a lasso.
+        bool isShift = (event->modifiers() & Qt::ShiftModifier);
+        bool isControl = (event->modifiers() & Qt::ControlModifier);
+        if(event->button() == Qt::LeftButton && (isShift || isControl))
+        {
+            isSelecting = true;
+            isLasso = isControl;
+            outline.assign(isLasso ? 1 : 2, origin);
+        }
+        else if(event->button() == Qt::RightButton)
             CreateSystem(origin);
         return;
     }
@@ -452,14 +603,28 @@ void GalaxyView::mousePressEvent(QMouseEvent *event)
     // already-selected system.
     if(event->button() == Qt::LeftButton)
     {
+        // Shift+click adds or removes a system from the group selection.
+        if(event->modifiers() & Qt::ShiftModifier)
+        {
+            if(!selection.erase(dragSystem->TrueName()))
+                selection.insert(dragSystem->TrueName());
+            dragSystem = nullptr;
+            update();
+            return;
+        }
+        // Clicking a system outside the group selection starts over. Clicking
+        // one inside it keeps the group, so that they can be dragged together.
+        if(!selection.count(dragSystem->TrueName()))
+            selection.clear();
+
         dragTime.start();
         clickOff = QVector2D(event->pos());
         if(systemView)
         {
             systemView->Select(dragSystem);
             // Update the coloring scheme if coloring by government.
-            if(!government.isEmpty() && !dragSystem->Government().isEmpty())
-                government = dragSystem->Government();
+            if(!renderer.Government().isEmpty() && !dragSystem->Government().isEmpty())
+                renderer.SetGovernment(dragSystem->Government());
             update();
         }
     }
@@ -468,7 +633,8 @@ void GalaxyView::mousePressEvent(QMouseEvent *event)
         if(systemView && systemView->Selected())
         {
             systemView->Selected()->ToggleLink(dragSystem);
-            mapData.SetChanged();
+            mapData.History().ToggleLink(systemView->Selected()->TrueName(), dragSystem->TrueName());
+            mapData.SetChanged(true, Map::LINKS);
             update();
         }
         dragSystem = nullptr;
@@ -504,6 +670,17 @@ void GalaxyView::mouseMoveEvent(QMouseEvent *event)
     if(!(event->buttons() & Qt::LeftButton))
         return;
 
+    if(isSelecting)
+    {
+        QVector2D point = MapPoint(event->pos());
+        if(!isLasso)
+            outline.back() = point;
+        else if(outline.back().distanceToPoint(point) * scale >= 3.)
+            outline.push_back(point);
+        update();
+        return;
+    }
+
     QVector2D distance = QVector2D(event->pos()) - clickOff;
     if(!dragSystem)
         offset = distance;
@@ -512,8 +689,27 @@ void GalaxyView::mouseMoveEvent(QMouseEvent *event)
         if(dragTime.elapsed() < 1000 && distance.length() < 5.)
             return;
 
-        dragSystem->SetPosition(dragSystem->Position() + distance / scale);
-        mapData.SetChanged();
+        // Dragging any system in the group selection moves the whole group.
+        vector<QString> names;
+        if(selection.count(dragSystem->TrueName()))
+        {
+            for(const QString &name : selection)
+            {
+                auto it = mapData.Systems().find(name);
+                if(it != mapData.Systems().end())
+                {
+                    it->second.SetPosition(it->second.Position() + distance / scale);
+                    names.push_back(name);
+                }
+            }
+        }
+        else
+        {
+            dragSystem->SetPosition(dragSystem->Position() + distance / scale);
+            names.push_back(dragSystem->TrueName());
+        }
+        mapData.History().MoveSystems(names, distance / scale, true);
+        mapData.SetChanged(true, Map::POSITIONS);
         clickOff = QVector2D(event->pos());
     }
     update();
@@ -521,6 +717,17 @@ void GalaxyView::mouseMoveEvent(QMouseEvent *event)
 
 
 
+void GalaxyView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if(isSelecting && event->button() == Qt::LeftButton)
+    {
+        FinishSelecting();
+        update();
+    }
+}
+
+
+
 // Zoom in or out.
 void GalaxyView::wheelEvent(QWheelEvent *event)
 {
@@ -540,9 +747,7 @@ void GalaxyView::wheelEvent(QWheelEvent *event)
 
 void GalaxyView::paintEvent(QPaintEvent */*event*/)
 {
-    QPen blackPen;
-    QPen mediumPen(QColor(120, 120, 120));
-    QPen brightPen(QColor(180, 180, 180));
+    profiler.Begin();
 
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing, true);
@@ -552,73 +757,28 @@ void GalaxyView::paintEvent(QPaintEvent */*event*/)
     painter.translate(offset.x(), offset.y());
     painter.scale(scale, scale);
 
-    // Draw the "galaxy" images.
-    for(const Galaxy &it : mapData.Galaxies())
-    {
-        QPixmap sprite = SpriteSet::Get(it.Sprite());
-        QPointF pos = (it.Position() - QVector2D(.5 * sprite.width(), .5 * sprite.height())).toPointF();
-        painter.drawPixmap(pos, sprite);
-    }
+    renderer.SetSelected(systemView ? systemView->Selected() : nullptr);
+    renderer.Draw(painter, &profiler);
 
-    // Draw the links between systems.
-    painter.setBrush(Qt::NoBrush);
-    for(const auto &it : mapData.Systems())
+    // Draw the rubber band or lasso that is being dragged out.
+    if(isSelecting)
     {
-        QPointF pos = it.second.Position().toPointF();
-        for(const QString &link : it.second.Links())
+        QPen pen(QColor(255, 200, 0), 0., Qt::DashLine);
+        painter.setPen(pen);
+        painter.setBrush(QColor(255, 200, 0, 32));
+        if(isLasso)
         {
-            auto lit = mapData.Systems().find(link);
-            if(lit == mapData.Systems().end())
-                continue;
-
-            double value = 0.;
-            if(!commodity.isEmpty())
-            {
-                int difference = abs(it.second.Trade(commodity) - lit->second.Trade(commodity));
-                value = (difference - 60) / 60.;
-            }
-            else if(!government.isEmpty())
-                value = (it.second.Government() != lit->second.Government());
-            // Set the link color based on the "value".
-            QPen pen(value < 1. ? MapGrey(value) : QColor(255, 0, 0));
-            painter.setPen(pen);
-            painter.drawLine(pos, lit->second.Position().toPointF());
+            QPolygonF polygon;
+            for(const QVector2D &point : outline)
+                polygon << point.toPointF();
+            painter.drawPolygon(polygon);
         }
+        else
+            painter.drawRect(QRectF(outline.front().toPointF(), outline.back().toPointF()));
     }
 
-    // Draw the systems, colored by commodity or if the government is the selected government.
-    for(const auto &it : mapData.Systems())
-    {
-        QPointF pos = it.second.Position().toPointF();
-        bool isSelected = (systemView && &it.second == systemView->Selected());
-        double value = 0.;
-        if(!commodity.isEmpty())
-            value = mapData.MapPrice(commodity, it.second.Trade(commodity)) * 2. - 1.;
-        else if(!government.isEmpty())
-            value = (it.second.Government() == government);
-        // Set the link color based on the "value".
-        QColor color = MapColor(value);
-        if(isSelected)
-            color.setRgbF(color.redF() * 1.5, color.greenF() * 1.5, color.blueF() * 1.5);
-        QBrush brush(color);
-        painter.setBrush(brush);
-        painter.setPen(blackPen);
-        painter.drawEllipse(pos, 5, 5);
-
-        painter.drawText(pos + QPointF(6, 6), it.first);
-        painter.setPen(brightPen);
-        painter.drawText(pos + QPointF(5, 5), it.first);
-    }
-
-    // Draw the selection circle and neighbor radius ring.
-    painter.setPen(mediumPen);
-    painter.setBrush(Qt::NoBrush);
-    if(systemView && systemView->Selected())
-    {
-        QPointF pos = systemView->Selected()->Position().toPointF();
-        painter.drawEllipse(pos, 10, 10);
-        painter.drawEllipse(pos, 100, 100);
-    }
+    profiler.End();
+    profiler.Draw(painter);
 }
 
 
@@ -646,7 +806,8 @@ void GalaxyView::CreateSystem(const QVector2D &origin)
         else
         {
             System &system = mapData.Systems()[text];
-            system.Init(text, origin);
+            Random random(Random::NewSeed());
+            system.Init(text, origin, random);
             // If a previous system was selected, the new system extends from it.
             if(systemView && systemView->Selected())
             {
@@ -658,6 +819,7 @@ void GalaxyView::CreateSystem(const QVector2D &origin)
             else
                 for(const Map::Commodity &commodity : mapData.Commodities())
                     system.SetTrade(commodity.name, (commodity.low + commodity.high) / 2);
+            mapData.History().CreateSystem(system, random.Seed());
             if(systemView)
                 systemView->Select(&system);
             mapData.SetChanged();
@@ -665,3 +827,139 @@ void GalaxyView::CreateSystem(const QVector2D &origin)
         }
     }
 }
+
+
+
+// Select every system whose stellar objects break the spacing rules, and
+// list the first few errors.
+void GalaxyView::CheckOrbits()
+{
+    vector<OrbitValidator::Result> results = OrbitValidator::Check(mapData);
+    if(results.empty())
+    {
+        QMessageBox::information(this, "Check orbits", "Every system follows the spacing rules.");
+        return;
+    }
+
+    selection.clear();
+    QString text;
+    int listed = 0;
+    for(const OrbitValidator::Result &result : results)
+    {
+        selection.insert(result.system);
+        const System &system = mapData.Systems().at(result.system);
+        for(const System::SpacingError &error : result.errors)
+            if(listed++ < MAX_LISTED_ERRORS)
+                text += OrbitValidator::Describe(system, error) + "\n";
+    }
+    if(listed > MAX_LISTED_ERRORS)
+        text += "...and " + QString::number(listed - MAX_LISTED_ERRORS) + " more.\n";
+    update();
+
+    QMessageBox::warning(this, "Check orbits", QString::number(results.size())
+        + (results.size() == 1 ? " system breaks" : " systems break")
+        + " the spacing rules, and " + (results.size() == 1 ? "is" : "are") + " now selected.\n\n" + text);
+}
+
+
+
+// Select every system that matches the given query (see MapQuery), and
+// say how many matched, or what is wrong with the query.
+QString GalaxyView::Search(const QString &query)
+{
+    // Clearing the search box only clears the selection if it is still the one
+    // the search made, not one made by hand since.
+    if(query.trimmed().isEmpty())
+    {
+        if(!searchSelection.empty() && selection == searchSelection)
+            SelectNone();
+        searchSelection.clear();
+        return QString();
+    }
+
+    if(!searchQuery || searchRevision != mapData.Revision())
+    {
+        searchQuery.emplace(mapData);
+        searchRevision = mapData.Revision();
+    }
+
+    // While the query is being typed, it is often incomplete. Keep the last
+    // selection until it makes sense again.
+    vector<QString> matches;
+    QString error;
+    if(!searchQuery->Find(query, matches, error))
+        return error;
+
+    selection.clear();
+    selection.insert(matches.begin(), matches.end());
+    searchSelection = selection;
+    update();
+    return QString::number(matches.size()) + (matches.size() == 1 ? " system matches." : " systems match.");
+}
+
+
+
+// Add the systems inside the rubber band or lasso to the group selection.
+void GalaxyView::FinishSelecting()
+{
+    isSelecting = false;
+
+    QPolygonF polygon;
+    for(const QVector2D &point : outline)
+        polygon << point.toPointF();
+    QRectF bounds = isLasso ? polygon.boundingRect()
+        : QRectF(outline.front().toPointF(), outline.back().toPointF()).normalized();
+    region = isLasso ? polygon : QPolygonF(bounds);
+    outline.clear();
+
+    // Only the systems in the grid cells under the outline need to be checked.
+    UpdateGrid();
+    for(int i : grid.Query(bounds))
+    {
+        if(isLasso && !polygon.containsPoint(gridPoints[i], Qt::OddEvenFill))
+            continue;
+        selection.insert(gridNames[i]);
+    }
+}
+
+
+
+// Make sure the grid of system positions matches the map. Any edit may have
+// moved, created, or deleted a system, so it is rebuilt after every one.
+void GalaxyView::UpdateGrid()
+{
+    if(gridRevision == mapData.Revision() && gridNames.size() == mapData.Systems().size())
+        return;
+    gridRevision = mapData.Revision();
+
+    grid.Clear();
+    gridNames.clear();
+    gridPoints.clear();
+    for(const auto &it : mapData.Systems())
+    {
+        grid.Add(it.second.Position().toPointF(), gridNames.size());
+        gridNames.push_back(it.first);
+        gridPoints.push_back(it.second.Position().toPointF());
+    }
+}
+
+
+
+// Apply the given change to every selected system, as a single edit. It only
+// changes the given parts of the map.
+void GalaxyView::EditSelection(unsigned parts, const function<void(System &)> &edit)
+{
+    if(selection.empty())
+        return;
+
+    for(const QString &name : selection)
+    {
+        auto it = mapData.Systems().find(name);
+        if(it != mapData.Systems().end())
+            edit(it->second);
+    }
+    mapData.SetChanged(true, parts);
+    if(detailView)
+        detailView->Reload();
+    update();
+}
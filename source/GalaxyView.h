@@ -13,11 +13,22 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef GALAXYVIEW_H
 #define GALAXYVIEW_H
 
+#include "GalaxyRenderer.h"
+#include "MapQuery.h"
+#include "PaintProfiler.h"
+#include "SpatialGrid.h"
+
 #include <QWidget>
 
+#include <QPolygonF>
 #include <QVector2D>
 #include <QElapsedTimer>
 
+#include <functional>
+#include <optional>
+#include <set>
+#include <vector>
+
 class DetailView;
 class Map;
 class System;
@@ -40,19 +51,37 @@ public:
     void SetGovernment(const QString &name);
     void KeyPress(QKeyEvent *event);
 
+    // Get the names of the systems in the group selection.
+    const std::set<QString> &Selection() const;
+    // Select every system that matches the given query (see MapQuery), and
+    // say how many matched, or what is wrong with the query.
+    QString Search(const QString &query);
+
 signals:
 
 public slots:
     void CreateSystem();
+    // Fill the last selected region with new systems.
+    void GenerateRegion();
     bool RenameSystem(const QString &from, const QString &to);
     void DeleteSystem();
     void Recenter();
     void RandomizeCommodity();
+    void ToggleHeatmap();
+    // Select every system whose stellar objects break the spacing rules.
+    void CheckOrbits();
+
+    // Edit every system in the group selection at once.
+    void SelectNone();
+    void SetSelectionGovernment();
+    void SetSelectionTrade();
+    void ToggleSelectionHidden();
 
 protected:
     virtual void mousePressEvent(QMouseEvent *event) override;
     virtual void mouseDoubleClickEvent(QMouseEvent *event) override;
     virtual void mouseMoveEvent(QMouseEvent *event) override;
+    virtual void mouseReleaseEvent(QMouseEvent *event) override;
     virtual void wheelEvent(QWheelEvent *event) override;
 
     virtual void paintEvent(QPaintEvent *event) override;
@@ -60,6 +89,13 @@ protected:
 private:
     QVector2D MapPoint(QPoint pos) const;
     void CreateSystem(const QVector2D &origin);
+    // Add the systems inside the rubber band or lasso to the group selection.
+    void FinishSelecting();
+    // Make sure the grid of system positions matches the map.
+    void UpdateGrid();
+    // Apply the given change to every selected system, as a single edit. It
+    // only changes the given parts of the map.
+    void EditSelection(unsigned parts, const std::function<void(System &)> &edit);
 
 
 private:
@@ -77,9 +113,30 @@ private:
     System *dragSystem = nullptr;
     QElapsedTimer dragTime;
 
-    // Color systems by:
-    QString commodity;
-    QString government;
+    // Group selection, by system name. While selecting, the points are the
+    // corners of the rubber band, or the outline of the lasso.
+    std::set<QString> selection;
+    bool isSelecting = false;
+    bool isLasso = false;
+    std::vector<QVector2D> outline;
+    // The outline of the last group selection, for generating systems in.
+    QPolygonF region;
+    // Every system's position, sorted into a grid for finding the ones inside
+    // a selection. It is rebuilt only if the map has changed since.
+    SpatialGrid grid;
+    std::vector<QString> gridNames;
+    std::vector<QPointF> gridPoints;
+    unsigned gridRevision = 0;
+    // The columns the search box queries, rebuilt only if the map has changed
+    // since the last search, and the systems the last search selected.
+    std::optional<MapQuery> searchQuery;
+    unsigned searchRevision = 0;
+    std::set<QString> searchSelection;
+
+    // The renderer remembers what the systems are colored by.
+    GalaxyRenderer renderer;
+
+    PaintProfiler profiler;
 };
 
 
@@ -39,8 +39,8 @@ namespace {
 
 
 
-LandscapeView::LandscapeView(const Map &mapData, QWidget *parent) :
-    QWidget(parent), mapData(mapData)
+LandscapeView::LandscapeView(Map &mapData, QWidget *parent) :
+    QWidget(parent), mapData(mapData), profiler("Landscape")
 {
     loader.Init();
 }
@@ -97,7 +97,10 @@ void LandscapeView::mousePressEvent(QMouseEvent *event)
             {
                 SetLandscape(loader.Available()[index]);
                 if(planet)
+                {
                     planet->SetLandscape(landscape);
+                    mapData.SetChanged(true, Map::PLANETS);
+                }
             }
         }
     }
@@ -108,6 +111,7 @@ void LandscapeView::mousePressEvent(QMouseEvent *event)
 
 void LandscapeView::paintEvent(QPaintEvent */*event*/)
 {
+    profiler.Begin();
     loader.Update();
 
     QPainter painter(this);
@@ -115,16 +119,18 @@ void LandscapeView::paintEvent(QPaintEvent */*event*/)
 
     if(!showGallery)
     {
-        if(landscape.isEmpty())
-            return;
-
-        QPixmap image = SpriteSet::Get(landscape);
-        if(image.isNull())
-            return;
-
-        int x = (width() - image.width()) / 2;
-        int y = (height() - image.height()) / 2;
-        painter.drawPixmap(x, y, image);
+        QPixmap image;
+        if(!landscape.isEmpty())
+            image = SpriteSet::Get(landscape);
+        if(!image.isNull())
+        {
+            int x = (width() - image.width()) / 2;
+            int y = (height() - image.height()) / 2;
+            painter.drawPixmap(x, y, image);
+            profiler.Count(PaintProfiler::SPRITES);
+        }
+        profiler.End();
+        profiler.Draw(painter);
         return;
     }
 
@@ -146,7 +152,11 @@ void LandscapeView::paintEvent(QPaintEvent */*event*/)
             painter.drawPixmap(QPoint(), image);
             painter.scale(THUMB_SCALE, THUMB_SCALE);
             painter.translate(-x, -y);
+            profiler.Count(PaintProfiler::SPRITES);
         }
+
+    profiler.End();
+    profiler.Draw(painter);
 }
 
 
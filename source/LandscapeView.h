@@ -13,6 +13,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef LANDSCAPEVIEW_H
 #define LANDSCAPEVIEW_H
 
+#include "PaintProfiler.h"
+
 #include <QWidget>
 
 class Map;
@@ -24,7 +26,7 @@ class LandscapeView : public QWidget
 {
     Q_OBJECT
 public:
-    explicit LandscapeView(const Map &mapData, QWidget *parent = 0);
+    explicit LandscapeView(Map &mapData, QWidget *parent = 0);
     ~LandscapeView();
 
     void Reinitialize();
@@ -45,10 +47,12 @@ private:
 
 
 private:
-    const Map &mapData;
+    Map &mapData;
     Planet *planet = nullptr;
     bool showGallery = false;
     QString landscape;
+
+    PaintProfiler profiler;
 };
 
 #endif // LANDSCAPEVIEW_H
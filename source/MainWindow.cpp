@@ -13,26 +13,44 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "MainWindow.h"
 
 #include "DetailView.h"
+#include "EditHistory.h"
 #include "GalaxyView.h"
 #include "Map.h"
+#include "MapChecker.h"
+#include "MapQuery.h"
+#include "PaintProfiler.h"
 #include "PlanetView.h"
+#include "System.h"
 #include "SystemView.h"
 
 #include <QAction>
 #include <QDragEnterEvent>
 #include <QFileDialog>
 #include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
 #include <QMenu>
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QMimeData>
 #include <QSizePolicy>
+#include <QStatusBar>
 #include <QString>
+#include <QStringList>
 #include <QTabWidget>
+#include <QTimer>
 #include <QUrl>
 
 using namespace std;
 
+namespace {
+    // How long to wait after the last edit before checking the map again, in
+    // milliseconds.
+    const int CHECK_DELAY = 500;
+    // How many problems to list in the status bar's tooltip.
+    const int MAX_LISTED_PROBLEMS = 20;
+}
+
 
 
 MainWindow::MainWindow(Map &map, QWidget *parent)
@@ -50,6 +68,7 @@ MainWindow::MainWindow(Map &map, QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    map.SetChangeCallback(nullptr);
 }
 
 
@@ -60,12 +79,15 @@ void MainWindow::DoOpen(const QString &path)
         return;
 
     map.Load(path);
+    galaxyView->SelectNone();
     galaxyView->Center();
     systemView->Select(nullptr);
     planetView->Reinitialize();
     tabs->setCurrentWidget(galaxyView);
     galaxyView->update();
     update();
+
+    CheckMap();
 }
 
 
@@ -88,8 +110,7 @@ void MainWindow::NewMap()
     if(!path.isEmpty())
     {
         // Create the empty map file.
-        map = Map();
-        map.Save(path);
+        Map().Save(path);
         // Initialize the editor with the empty map.
         DoOpen(path);
         // Create a system at (0, 0).
@@ -151,6 +172,44 @@ void MainWindow::Quit()
 
 
 
+void MainWindow::Undo()
+{
+    if(map.History().CanUndo())
+        AfterUndo(map.History().Undo(map));
+}
+
+
+
+void MainWindow::Redo()
+{
+    if(map.History().CanRedo())
+        AfterUndo(map.History().Redo(map));
+}
+
+
+
+// Describe what undo and redo would do, whenever the Edit menu is opened.
+void MainWindow::UpdateEditMenu()
+{
+    const EditHistory &history = map.History();
+    undoAction->setText(history.CanUndo() ? "Undo " + history.UndoText() : "Undo");
+    redoAction->setText(history.CanRedo() ? "Redo " + history.RedoText() : "Redo");
+    undoAction->setEnabled(history.CanUndo());
+    redoAction->setEnabled(history.CanRedo());
+}
+
+
+
+// The shortcuts must keep working while the menu is closed, even if there was
+// nothing to undo when it was last opened.
+void MainWindow::EnableEditMenu()
+{
+    undoAction->setEnabled(true);
+    redoAction->setEnabled(true);
+}
+
+
+
 void MainWindow::TabChanged(int)
 {
     if(tabs)
@@ -162,6 +221,56 @@ void MainWindow::TabChanged(int)
 
 
 
+// Show or hide the paint time overlay in all the views.
+void MainWindow::ToggleProfiler()
+{
+    PaintProfiler::SetEnabled(!PaintProfiler::IsEnabled());
+    if(tabs && tabs->currentWidget())
+        tabs->currentWidget()->update();
+}
+
+
+
+// Check the map for consistency problems, running only the rules that depend
+// on what has changed since the last check, and show how many there are in
+// the status bar.
+void MainWindow::CheckMap()
+{
+    const vector<MapChecker::Finding> &findings = checker.Update(map);
+    if(findings.empty())
+    {
+        problemLabel->setText("No map problems");
+        problemLabel->setToolTip(QString());
+        return;
+    }
+
+    problemLabel->setText(QString::number(findings.size())
+        + (findings.size() == 1 ? " map problem" : " map problems"));
+    QStringList lines;
+    for(const MapChecker::Finding &finding : findings)
+    {
+        if(lines.size() == MAX_LISTED_PROBLEMS)
+        {
+            lines.append("...");
+            break;
+        }
+        lines.append(MapChecker::Describe(map, finding));
+    }
+    problemLabel->setToolTip(lines.join("\n"));
+}
+
+
+
+// Select the systems that match what is typed in the search box.
+void MainWindow::Search(const QString &query)
+{
+    if(!query.isEmpty())
+        tabs->setCurrentWidget(galaxyView);
+    statusBar()->showMessage(galaxyView->Search(query));
+}
+
+
+
 void MainWindow::keyPressEvent(QKeyEvent *event)
 {
     if(tabs)
@@ -244,6 +353,57 @@ void MainWindow::CreateWidgets()
     layout->addWidget(tabs);
 
     connect(tabs, SIGNAL(currentChanged(int)), this, SLOT(TabChanged(int)));
+
+    // The search box selects the matching systems in the galaxy view.
+    QLineEdit *search = new QLineEdit(tabs);
+    search->setPlaceholderText("Search systems");
+    search->setClearButtonEnabled(true);
+    search->setToolTip(MapQuery::Help());
+    tabs->setCornerWidget(search);
+    connect(search, SIGNAL(textChanged(const QString &)), this, SLOT(Search(const QString &)));
+
+    // Check the map again shortly after each edit (i.e. each time the map is
+    // marked as changed), rather than after every step of a drag. Nothing
+    // runs while the map is not being edited.
+    problemLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(problemLabel);
+    checkTimer = new QTimer(this);
+    checkTimer->setSingleShot(true);
+    connect(checkTimer, SIGNAL(timeout()), this, SLOT(CheckMap()));
+    map.SetChangeCallback([this]()
+    {
+        checkTimer->start(CHECK_DELAY);
+    });
+    CheckMap();
+}
+
+
+
+// Refresh all the views after an edit was undone or redone, selecting the
+// system it changed if there is one.
+void MainWindow::AfterUndo(const QString &name)
+{
+    // The undone edit may have deleted the system that was selected.
+    System *selected = nullptr;
+    for(auto &it : map.Systems())
+    {
+        if(it.first == name)
+        {
+            selected = &it.second;
+            break;
+        }
+        if(&it.second == systemView->Selected())
+            selected = &it.second;
+    }
+
+    // Objects may have been replaced, so nothing in the old system can still
+    // be selected.
+    map.SetChanged();
+    planetView->SetPlanet(nullptr);
+    systemView->Select(selected);
+    detailView->Reload();
+    galaxyView->update();
+    systemView->update();
 }
 
 
@@ -270,12 +430,37 @@ void MainWindow::CreateMenus()
         quitAction->setShortcut(QKeySequence::Quit);
     }
 
+    // Edit Menu:
+    QMenu *editMenu = menuBar()->addMenu("Edit");
+    {
+        undoAction = editMenu->addAction("Undo", this, SLOT(Undo()));
+        undoAction->setShortcut(QKeySequence::Undo);
+
+        redoAction = editMenu->addAction("Redo", this, SLOT(Redo()));
+        redoAction->setShortcut(QKeySequence::Redo);
+
+        connect(editMenu, SIGNAL(aboutToShow()), this, SLOT(UpdateEditMenu()));
+        connect(editMenu, SIGNAL(aboutToHide()), this, SLOT(EnableEditMenu()));
+    }
+
+    // View Menu:
+    QMenu *viewMenu = menuBar()->addMenu("View");
+    {
+        QAction *profilerAction = viewMenu->addAction("Paint Profiler", this, SLOT(ToggleProfiler()));
+        profilerAction->setCheckable(true);
+        profilerAction->setChecked(PaintProfiler::IsEnabled());
+        profilerAction->setShortcut(QKeySequence(Qt::Key_F3));
+    }
+
     // Galaxy Menu:
     galaxyMenu = menuBar()->addMenu("Galaxy");
     {
         QAction *createSystemAction = galaxyMenu->addAction("Create System");
         connect(createSystemAction, SIGNAL(triggered()), galaxyView, SLOT(CreateSystem()));
 
+        QAction *generateRegionAction = galaxyMenu->addAction("Generate Region...");
+        connect(generateRegionAction, SIGNAL(triggered()), galaxyView, SLOT(GenerateRegion()));
+
         QAction *deleteSystemAction = galaxyMenu->addAction("Delete System");
         connect(deleteSystemAction, SIGNAL(triggered()), galaxyView, SLOT(DeleteSystem()));
         deleteSystemAction->setShortcut(QKeySequence(Qt::Key_Backspace));
@@ -288,6 +473,28 @@ void MainWindow::CreateMenus()
         QAction *randomizeCommodityAction = galaxyMenu->addAction("Randomize Commodity");
         connect(randomizeCommodityAction, SIGNAL(triggered()), galaxyView, SLOT(RandomizeCommodity()));
         randomizeCommodityAction->setShortcut(QKeySequence("C"));
+
+        QAction *heatmapAction = galaxyMenu->addAction("Show Price Heatmap");
+        connect(heatmapAction, SIGNAL(triggered()), galaxyView, SLOT(ToggleHeatmap()));
+        heatmapAction->setCheckable(true);
+        heatmapAction->setShortcut(QKeySequence("Shift+C"));
+        galaxyMenu->addSeparator();
+
+        QAction *checkOrbitsAction = galaxyMenu->addAction("Check Orbits");
+        connect(checkOrbitsAction, SIGNAL(triggered()), galaxyView, SLOT(CheckOrbits()));
+
+        QAction *selectNoneAction = galaxyMenu->addAction("Select None");
+        connect(selectNoneAction, SIGNAL(triggered()), galaxyView, SLOT(SelectNone()));
+        selectNoneAction->setShortcut(QKeySequence(Qt::Key_Escape));
+
+        QAction *selectionGovernmentAction = galaxyMenu->addAction("Set Government of Selection...");
+        connect(selectionGovernmentAction, SIGNAL(triggered()), galaxyView, SLOT(SetSelectionGovernment()));
+
+        QAction *selectionTradeAction = galaxyMenu->addAction("Set Commodity Price of Selection...");
+        connect(selectionTradeAction, SIGNAL(triggered()), galaxyView, SLOT(SetSelectionTrade()));
+
+        QAction *selectionHiddenAction = galaxyMenu->addAction("Toggle Hidden in Selection");
+        connect(selectionHiddenAction, SIGNAL(triggered()), galaxyView, SLOT(ToggleSelectionHidden()));
     }
 
     // System Menu:
@@ -305,6 +512,9 @@ void MainWindow::CreateMenus()
         connect(randomUninhabited, SIGNAL(triggered()), systemView, SLOT(RandomizeUninhabited()));
         randomUninhabited->setShortcut(QKeySequence("U"));
 
+        QAction *randomConstrained = systemMenu->addAction("Randomize With Constraints...");
+        connect(randomConstrained, SIGNAL(triggered()), systemView, SLOT(RandomizeConstrained()));
+
         systemMenu->addSeparator();
 
         QAction *changeAsteroids = systemMenu->addAction("Change Asteroids");
@@ -13,6 +13,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "MapChecker.h"
+
 #include <QMainWindow>
 
 class Map;
@@ -21,11 +23,14 @@ class GalaxyView;
 class SystemView;
 class PlanetView;
 
+class QAction;
+class QLabel;
 class QDragEnterEvent;
 class QDropEvent;
 class QMenu;
 class QString;
 class QTabWidget;
+class QTimer;
 
 
 
@@ -46,7 +51,19 @@ public slots:
     void SaveAs();
     void Quit();
 
+    void Undo();
+    void Redo();
+    void UpdateEditMenu();
+    void EnableEditMenu();
+
     void TabChanged(int);
+    void ToggleProfiler();
+    // Check the map for consistency problems, running only the rules that
+    // depend on what has changed since the last check, and show how many
+    // there are in the status bar.
+    void CheckMap();
+    // Select the systems that match what is typed in the search box.
+    void Search(const QString &query);
 
 protected:
     virtual void keyPressEvent(QKeyEvent *event) override;
@@ -57,6 +74,9 @@ protected:
 private:
     void CreateWidgets();
     void CreateMenus();
+    // Refresh all the views after an edit was undone or redone, selecting the
+    // system it changed if there is one.
+    void AfterUndo(const QString &name);
 
 
 private:
@@ -68,8 +88,16 @@ private:
     SystemView *systemView = nullptr;
     PlanetView *planetView = nullptr;
 
+    QAction *undoAction = nullptr;
+    QAction *redoAction = nullptr;
     QMenu *galaxyMenu = nullptr;
     QMenu *systemMenu = nullptr;
+
+    QLabel *problemLabel = nullptr;
+    // The map is checked again a moment after each edit, so that a drag is
+    // only checked once it stops.
+    QTimer *checkTimer = nullptr;
+    MapChecker checker;
 };
 
 #endif // MAINWINDOW_H
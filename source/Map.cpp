@@ -20,15 +20,28 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <QString>
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <utility>
 
 using namespace std;
 
+namespace {
+    // Revision numbers are shared by all maps, so that loading a new map never
+    // reuses the revision of the one it replaced.
+    atomic<unsigned> lastRevision;
+}
+
 
 
 void Map::Load(const QString &path)
 {
     // Clear everything first.
+    function<void()> callback = std::move(changeCallback);
     *this = Map();
+    changeCallback = std::move(callback);
+    revision = ++lastRevision;
+    fill(begin(partRevisions), end(partRevisions), revision);
 
     QFileInfo p = QFileInfo(path);
 
@@ -40,6 +53,7 @@ void Map::Load(const QString &path)
 
     DataFile data(path);
     comments = data.Comments();
+    hasInteriorComments = data.HasInteriorComments();
 
     for(const DataNode &node : data)
     {
@@ -64,6 +78,16 @@ void Map::Load(const QString &path)
                 if(child.Token(0) == "commodity" && child.Size() >= 4)
                     commodities.emplace_back(child.Token(1), child.Value(2), child.Value(3));
 
+    // Governments are only needed for checking that the systems and planets
+    // refer to ones that exist.
+    DataFile governmentData(dataDirectory + "governments.txt");
+    for(const DataNode &node : governmentData)
+        if(node.Token(0) == "government" && node.Size() >= 2)
+            governments.insert(node.Token(1));
+    for(const DataNode &node : unparsed)
+        if(node.Token(0) == "government" && node.Size() >= 2)
+            governments.insert(node.Token(1));
+
     isChanged = false;
 }
 
@@ -75,6 +99,15 @@ void Map::Save(const QString &path)
 
     fileName = p.fileName();
     DataWriter file(path);
+    Save(file);
+    isChanged = false;
+}
+
+
+
+// Write all the information, without changing which file was chosen.
+void Map::Save(DataWriter &file) const
+{
     file.WriteRaw(comments);
     file.Write();
 
@@ -98,7 +131,6 @@ void Map::Save(const QString &path)
         file.Write(it);
         file.Write();
     }
-    isChanged = false;
 }
 
 
@@ -117,9 +149,29 @@ const QString &Map::FileName() const
 
 
 
-void Map::SetChanged(bool changed)
+// Check if the file had comments after its first entry. Saving the map
+// moves every comment to the top of the file.
+bool Map::HasInteriorComments() const
+{
+    return hasInteriorComments;
+}
+
+
+
+// Mark this file as changed. If the edit is known to only change some parts
+// of the map, the revisions of the other parts stay the same.
+void Map::SetChanged(bool changed, unsigned parts)
 {
     isChanged = changed;
+    if(!changed)
+        return;
+
+    revision = ++lastRevision;
+    for(int i = 0; i < PART_COUNT; ++i)
+        if(parts & (1u << i))
+            partRevisions[i] = revision;
+    if(changeCallback)
+        changeCallback();
 }
 
 
@@ -131,6 +183,36 @@ bool Map::IsChanged() const
 
 
 
+// Get a number that changes whenever the map is marked as changed or a new
+// map is loaded, so that anything derived from the map can be cached.
+unsigned Map::Revision() const
+{
+    return revision;
+}
+
+
+
+// Get the revision in which any of the given parts last changed.
+unsigned Map::Revision(unsigned parts) const
+{
+    unsigned latest = 0;
+    for(int i = 0; i < PART_COUNT; ++i)
+        if(parts & (1u << i))
+            latest = max(latest, partRevisions[i]);
+    return latest;
+}
+
+
+
+// Set a function to call whenever the map is marked as changed. Loading a new
+// map keeps it.
+void Map::SetChangeCallback(function<void()> callback)
+{
+    changeCallback = std::move(callback);
+}
+
+
+
 list<Galaxy> &Map::Galaxies()
 {
     return galaxies;
@@ -180,6 +262,15 @@ const vector<Map::Commodity> &Map::Commodities() const
 
 
 
+// Get the names of the governments that are defined in the data directory
+// or the map file. If none could be found, this is empty.
+const set<QString> &Map::Governments() const
+{
+    return governments;
+}
+
+
+
 // Map a price to a value between 0 and 1 (lowest vs. highest).
 double Map::MapPrice(const QString &commodity, int price) const
 {
@@ -237,6 +328,53 @@ void Map::RenameSystem(const QString &from, const QString &to)
 
 
 
+// Delete a system, along with the links to it from other systems.
+void Map::DeleteSystem(const QString &name)
+{
+    auto it = systems.find(name);
+    if(it == systems.end())
+        return;
+
+    // Remove all links from this system (and the corresponding return links, if able).
+    System *system = &it->second;
+    while(!system->Links().empty())
+    {
+        // The system to be deleted may have a link to a "plugin" system.
+        auto lit = systems.find(*system->Links().begin());
+        if(lit != systems.end())
+            system->ToggleLink(&lit->second);
+        // Only this system's endpoint can be modified.
+        else
+            system->ChangeLink(*system->Links().begin(), QString());
+    }
+    systems.erase(it);
+}
+
+
+
+// Add back a system that was deleted, and restore the links to it from
+// other systems.
+void Map::InsertSystem(const System &system)
+{
+    System &inserted = systems[system.TrueName()] = system;
+    inserted.UpdateObjectPointers();
+    for(const QString &link : inserted.Links())
+    {
+        auto it = systems.find(link);
+        if(it != systems.end())
+            it->second.AddLink(inserted.TrueName());
+    }
+}
+
+
+
+EditHistory &Map::History()
+{
+    return history;
+}
+
+
+
 // Rename a planet. The editor does not support planets sharing a name with
 // a system, or renaming an object to share a planet definition (i.e. wormholes).
 void Map::RenamePlanet(StellarObject *object, const QString &name)
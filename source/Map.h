@@ -13,31 +13,70 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef MAP_H
 #define MAP_H
 
+#include "EditHistory.h"
 #include "Galaxy.h"
 #include "Planet.h"
 #include "System.h"
 
+#include <functional>
 #include <list>
 #include <map>
+#include <set>
 #include <string>
 
 class DataNode;
+class DataWriter;
 class StellarObject;
 
 
 
 class Map {
+public:
+    // The parts of the map that an edit can change, so that anything that only
+    // depends on some of them can tell whether it needs to be updated.
+    enum Part : unsigned {
+        // Where the systems and their stellar objects are.
+        POSITIONS = 1,
+        LINKS = 2,
+        GOVERNMENTS = 4,
+        TRADE = 8,
+        // Which stellar objects each system has, and their sprites and names.
+        OBJECTS = 16,
+        // The planet entries, including their governments and landscapes.
+        PLANETS = 32,
+        // Which systems and planets exist, and their names.
+        NAMES = 64,
+        // Everything else about a system, e.g. its fleets or asteroids.
+        DETAILS = 128,
+        ALL_PARTS = 255
+    };
+
+
 public:
     // Load from the given file, and remember which file was read from.
     void Load(const QString &path);
     // Write all the information, and remember which file was chosen.
     void Save(const QString &path);
+    // Write all the information, without changing which file was chosen.
+    void Save(DataWriter &file) const;
     const QString &DataDirectory() const;
     const QString &FileName() const;
+    // Check if the file had comments after its first entry. Saving the map
+    // moves every comment to the top of the file.
+    bool HasInteriorComments() const;
 
-    // Mark this file as changed.
-    void SetChanged(bool changed = true);
+    // Mark this file as changed. If the edit is known to only change some
+    // parts of the map, the revisions of the other parts stay the same.
+    void SetChanged(bool changed = true, unsigned parts = ALL_PARTS);
     bool IsChanged() const;
+    // Get a number that changes whenever the map is marked as changed or a new
+    // map is loaded, so that anything derived from the map can be cached.
+    unsigned Revision() const;
+    // Get the revision in which any of the given parts last changed.
+    unsigned Revision(unsigned parts) const;
+    // Set a function to call whenever the map is marked as changed. Loading a
+    // new map keeps it.
+    void SetChangeCallback(std::function<void()> callback);
 
     std::list<Galaxy> &Galaxies();
     const std::list<Galaxy> &Galaxies() const;
@@ -54,6 +93,9 @@ public:
         Commodity(const QString &name, int low, int high) : name(name), low(low), high(high) {}
     };
     const std::vector<Commodity> &Commodities() const;
+    // Get the names of the governments that are defined in the data directory
+    // or the map file. If none could be found, this is empty.
+    const std::set<QString> &Governments() const;
     // Map a price to a value between 0 and 1 (lowest vs. highest).
     double MapPrice(const QString &commodity, int price) const;
     QString PriceLevel(const QString &commodity, int price) const;
@@ -62,6 +104,14 @@ public:
     // and moving it to a new place in the map.
     void RenameSystem(const QString &from, const QString &to);
     void RenamePlanet(StellarObject *object, const QString &name);
+    // Delete a system, along with the links to it from other systems. Adding
+    // it back restores those links.
+    void DeleteSystem(const QString &name);
+    void InsertSystem(const System &system);
+
+    // The record of edits that can be undone. It is cleared whenever a new
+    // map is loaded.
+    EditHistory &History();
 
 
 private:
@@ -72,11 +122,20 @@ private:
     std::map<QString, System> systems;
     std::map<QString, Planet> planets;
     std::vector<Commodity> commodities;
+    std::set<QString> governments;
 
     QString comments;
+    bool hasInteriorComments = false;
     std::list<DataNode> unparsed;
 
     mutable bool isChanged = false;
+    unsigned revision = 0;
+    // The revision in which each part last changed, in the order of their bits.
+    static const int PART_COUNT = 8;
+    unsigned partRevisions[PART_COUNT] = {};
+    std::function<void()> changeCallback;
+
+    EditHistory history;
 };
 
 #endif // MAP_H
@@ -0,0 +1,251 @@
+/* MapChecker.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MapChecker.h"
+
+#include "Map.h"
+#include "ParallelFor.h"
+#include "Planet.h"
+#include "StellarObject.h"
+#include "System.h"
+
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+    typedef MapChecker::Finding Finding;
+
+    // The map's systems and planets, numbered in order by name, so that the
+    // passes can refer to them by number instead of looking up names.
+    struct Snapshot {
+        vector<const System *> systems;
+        vector<const Planet *> planets;
+        unordered_map<QString, int> systemIds;
+        unordered_map<QString, int> planetIds;
+    };
+
+    // Every link must go both ways, to a system that exists.
+    void CheckLinks(const Map &, const Snapshot &snapshot, vector<Finding> &findings)
+    {
+        for(unsigned i = 0; i < snapshot.systems.size(); ++i)
+        {
+            const System &system = *snapshot.systems[i];
+            for(const QString &link : system.Links())
+            {
+                auto it = snapshot.systemIds.find(link);
+                if(it == snapshot.systemIds.end())
+                    findings.push_back({MapChecker::LINKS, system.SourceLine(),
+                        system.TrueName() + " links to " + link + ", which is not in this map."});
+                else if(it->second == static_cast<int>(i))
+                    findings.push_back({MapChecker::LINKS, system.SourceLine(),
+                        system.TrueName() + " links to itself."});
+                else if(!snapshot.systems[it->second]->Links().count(system.TrueName()))
+                    findings.push_back({MapChecker::LINKS, system.SourceLine(),
+                        system.TrueName() + " links to " + link + ", but " + link + " does not link back."});
+            }
+        }
+    }
+
+    // Every named object must have a planet entry, and every planet entry
+    // must be used by some object.
+    void CheckPlanets(const Map &, const Snapshot &snapshot, vector<Finding> &findings)
+    {
+        vector<int> uses(snapshot.planets.size());
+        for(const System *system : snapshot.systems)
+            for(const StellarObject &object : system->Objects())
+            {
+                if(object.GetPlanet().isEmpty())
+                    continue;
+                auto it = snapshot.planetIds.find(object.GetPlanet());
+                if(it == snapshot.planetIds.end())
+                    findings.push_back({MapChecker::PLANETS, system->SourceLine(), "The object " + object.GetPlanet()
+                        + " in " + system->TrueName() + " has no planet entry."});
+                else
+                    ++uses[it->second];
+            }
+        for(unsigned i = 0; i < snapshot.planets.size(); ++i)
+            if(!uses[i])
+                findings.push_back({MapChecker::PLANETS, snapshot.planets[i]->SourceLine(),
+                    "The planet " + snapshot.planets[i]->TrueName() + " is not in any system."});
+    }
+
+    // Systems and planets can only belong to known governments. If no
+    // governments were found, this cannot be checked.
+    void CheckGovernments(const Map &mapData, const Snapshot &snapshot, vector<Finding> &findings)
+    {
+        const set<QString> &known = mapData.Governments();
+        if(known.empty())
+            return;
+
+        for(const System *system : snapshot.systems)
+            if(!system->Government().isEmpty() && !known.count(system->Government()))
+                findings.push_back({MapChecker::GOVERNMENTS, system->SourceLine(), system->TrueName()
+                    + " belongs to the unknown government " + system->Government() + "."});
+        for(const Planet *planet : snapshot.planets)
+            if(!planet->Government().isEmpty() && !known.count(planet->Government()))
+                findings.push_back({MapChecker::GOVERNMENTS, planet->SourceLine(), planet->TrueName()
+                    + " belongs to the unknown government " + planet->Government() + "."});
+    }
+
+    // Any system with a market must price every known commodity, and nothing
+    // else. If no commodities were found, this cannot be checked.
+    void CheckCommodities(const Map &mapData, const Snapshot &snapshot, vector<Finding> &findings)
+    {
+        const vector<Map::Commodity> &commodities = mapData.Commodities();
+        if(commodities.empty())
+            return;
+
+        set<QString> known;
+        for(const Map::Commodity &commodity : commodities)
+            known.insert(commodity.name);
+        for(const System *system : snapshot.systems)
+        {
+            const map<QString, int> &trades = system->Trades();
+            if(trades.empty())
+                continue;
+            for(const auto &it : trades)
+                if(!known.count(it.first))
+                    findings.push_back({MapChecker::COMMODITIES, system->SourceLine(), system->TrueName()
+                        + " has a price for the unknown commodity " + it.first + "."});
+            for(const QString &name : known)
+                if(!trades.count(name))
+                    findings.push_back({MapChecker::COMMODITIES, system->SourceLine(), system->TrueName()
+                        + " has no price for " + name + "."});
+        }
+    }
+
+    // Each landscape should only be used by one planet.
+    void CheckLandscapes(const Map &, const Snapshot &snapshot, vector<Finding> &findings)
+    {
+        unordered_map<QString, int> owner;
+        for(unsigned i = 0; i < snapshot.planets.size(); ++i)
+        {
+            const Planet &planet = *snapshot.planets[i];
+            if(planet.Landscape().isEmpty())
+                continue;
+            auto it = owner.emplace(planet.Landscape(), i).first;
+            if(it->second != static_cast<int>(i))
+                findings.push_back({MapChecker::LANDSCAPES, planet.SourceLine(), planet.TrueName()
+                    + " has the same landscape as " + snapshot.planets[it->second]->TrueName() + "."});
+        }
+    }
+
+    // The passes, in the same order as the rules.
+    void (*const PASSES[])(const Map &, const Snapshot &, vector<Finding> &) = {
+        CheckLinks,
+        CheckPlanets,
+        CheckGovernments,
+        CheckCommodities,
+        CheckLandscapes
+    };
+    static_assert(sizeof(PASSES) / sizeof(PASSES[0]) == MapChecker::RULE_COUNT, "Every rule must have a pass.");
+
+    // The parts of the map each rule looks at. The messages name the systems
+    // and planets involved, so every rule depends on their names.
+    const unsigned INPUTS[] = {
+        Map::LINKS | Map::NAMES,
+        Map::OBJECTS | Map::PLANETS | Map::NAMES,
+        Map::GOVERNMENTS | Map::PLANETS | Map::NAMES,
+        Map::TRADE | Map::NAMES,
+        Map::PLANETS | Map::NAMES
+    };
+    static_assert(sizeof(INPUTS) / sizeof(INPUTS[0]) == MapChecker::RULE_COUNT, "Every rule must have inputs.");
+
+    const char *RULE_NAMES[] = {
+        "links",
+        "planets",
+        "governments",
+        "commodities",
+        "landscapes"
+    };
+}
+
+
+
+// Check the whole map, and return the findings in order by line.
+vector<Finding> MapChecker::Check(const Map &map)
+{
+    return MapChecker().Update(map);
+}
+
+
+
+// Check the map again, running only the rules whose inputs have changed since
+// this checker last looked at it, and return all the findings in order by line.
+const vector<Finding> &MapChecker::Update(const Map &map)
+{
+    vector<int> rules;
+    for(int rule = 0; rule < RULE_COUNT; ++rule)
+        if(!isChecked || checked[rule] != map.Revision(INPUTS[rule]))
+            rules.push_back(rule);
+    isChecked = true;
+    if(rules.empty())
+        return findings;
+
+    Snapshot snapshot;
+    for(const auto &it : map.Systems())
+    {
+        snapshot.systemIds[it.first] = snapshot.systems.size();
+        snapshot.systems.push_back(&it.second);
+    }
+    for(const auto &it : map.Planets())
+    {
+        snapshot.planetIds[it.first] = snapshot.planets.size();
+        snapshot.planets.push_back(&it.second);
+    }
+
+    ParallelFor(static_cast<int>(rules.size()), [&](int i)
+    {
+        int rule = rules[i];
+        results[rule].clear();
+        PASSES[rule](map, snapshot, results[rule]);
+        checked[rule] = map.Revision(INPUTS[rule]);
+    });
+
+    findings.clear();
+    for(const vector<Finding> &result : results)
+        findings.insert(findings.end(), result.begin(), result.end());
+    stable_sort(findings.begin(), findings.end(), [](const Finding &a, const Finding &b)
+    {
+        return a.line < b.line;
+    });
+    return findings;
+}
+
+
+
+const char *MapChecker::RuleName(Rule rule)
+{
+    return (rule >= 0 && rule < RULE_COUNT) ? RULE_NAMES[rule] : "";
+}
+
+
+
+// Get the parts of the map (see Map::Part) that the given rule looks at.
+unsigned MapChecker::Inputs(Rule rule)
+{
+    return (rule >= 0 && rule < RULE_COUNT) ? INPUTS[rule] : Map::ALL_PARTS;
+}
+
+
+
+// Describe a finding as "file:line: rule: message".
+QString MapChecker::Describe(const Map &map, const Finding &finding)
+{
+    QString location = map.DataDirectory() + map.FileName();
+    if(finding.line)
+        location += ":" + QString::number(finding.line);
+    return location + ": " + RuleName(finding.rule) + ": " + finding.message;
+}
@@ -0,0 +1,77 @@
+/* MapChecker.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MAPCHECKER_H_
+#define MAPCHECKER_H_
+
+#include <QString>
+
+#include <vector>
+
+class Map;
+
+
+
+// Class for checking that the parts of a map are consistent with each other:
+// that links go both ways, that every named stellar object has a planet entry
+// and every planet is in a system, that only known governments and commodities
+// are used, and that no two planets share a landscape. Each rule is a separate
+// pass over a snapshot of the map in which systems and planets are numbered,
+// so the passes share nothing and all run at once. This does not need a
+// display, so it can also be run from the command line. In the editor, a
+// checker object keeps each rule's findings, and after an edit only runs the
+// rules that depend on the parts of the map that changed.
+class MapChecker {
+public:
+    enum Rule {
+        LINKS,
+        PLANETS,
+        GOVERNMENTS,
+        COMMODITIES,
+        LANDSCAPES,
+        RULE_COUNT
+    };
+    struct Finding {
+        Rule rule;
+        // The line of the map file the problem is on, or 0 if the system or
+        // planet was created in the editor.
+        int line;
+        QString message;
+    };
+
+
+public:
+    // Check the whole map, and return the findings in order by line.
+    static std::vector<Finding> Check(const Map &map);
+    // Check the map again, running only the rules whose inputs have changed
+    // since this checker last looked at it, and return all the findings in
+    // order by line.
+    const std::vector<Finding> &Update(const Map &map);
+
+    static const char *RuleName(Rule rule);
+    // Get the parts of the map (see Map::Part) that the given rule looks at.
+    static unsigned Inputs(Rule rule);
+    // Describe a finding as "file:line: rule: message".
+    static QString Describe(const Map &map, const Finding &finding);
+
+
+private:
+    // The findings of each rule, and the revision of its inputs they are for.
+    std::vector<std::vector<Finding>> results = std::vector<std::vector<Finding>>(RULE_COUNT);
+    unsigned checked[RULE_COUNT] = {};
+    bool isChecked = false;
+    std::vector<Finding> findings;
+};
+
+
+
+#endif
@@ -0,0 +1,335 @@
+/* MapDiff.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MapDiff.h"
+
+#include "DataFile.h"
+#include "DataNode.h"
+#include "DataWriter.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+    typedef MapDiff::Change Change;
+    typedef MapDiff::Conflict Conflict;
+
+    // Fields that are matched by their second token as well as their first.
+    const char *NAMED_FIELDS[] = {"asteroids", "fleet", "hazard", "link", "minables", "outfitter", "shipyard", "trade"};
+
+    // Fields made of several nodes combine their hashes with FNV-1a.
+    const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    const uint64_t FNV_PRIME = 1099511628211ull;
+
+    // An entity or a field: the nodes it is made of, and their hash.
+    struct Item {
+        QString key;
+        vector<const DataNode *> nodes;
+        uint64_t hash = FNV_OFFSET;
+    };
+
+    // The items of a file or an entity, in order, and the index of each one.
+    struct Index {
+        vector<Item> items;
+        unordered_map<QString, int> keys;
+
+        const Item *Find(const QString &key) const
+        {
+            auto it = keys.find(key);
+            return (it == keys.end() ? nullptr : &items[it->second]);
+        }
+        Item &Get(const QString &key)
+        {
+            auto it = keys.emplace(key, items.size()).first;
+            if(it->second == static_cast<int>(items.size()))
+            {
+                items.emplace_back();
+                items.back().key = key;
+            }
+            return items[it->second];
+        }
+    };
+
+    QString Quoted(const QString &token)
+    {
+        bool hasSpace = false;
+        for(const QChar &c : token)
+            hasSpace |= c.isSpace();
+        if(!hasSpace && !token.isEmpty())
+            return token;
+        return (token.contains('"') ? "`" + token + "`" : "\"" + token + "\"");
+    }
+
+    // Get one line of a node as it would be written in a data file.
+    QString Text(const DataNode &node)
+    {
+        QString text;
+        for(int i = 0; i < node.Size(); ++i)
+            text += (i ? " " : "") + Quoted(node.Token(i));
+        return text;
+    }
+
+    // Get the first line of a file's comments, with "..." after it if there
+    // is more.
+    QString CommentSummary(const QString &comments)
+    {
+        int end = comments.indexOf('\n');
+        if(end < 0 || end == comments.length() - 1)
+            return comments.trimmed();
+        return comments.left(end).trimmed() + " ...";
+    }
+
+    // Get the first line of an item, with "..." after it if there is more.
+    QString Summary(const Item *item)
+    {
+        if(!item || item->nodes.empty())
+            return QString();
+        const DataNode &first = *item->nodes.front();
+        bool isMore = (item->nodes.size() > 1 || first.HasChildren());
+        return Text(first) + (isMore ? " ..." : "");
+    }
+
+    // Each entity is keyed by its whole first line. If that line is repeated,
+    // the copies are numbered.
+    Index Entities(const DataFile &file)
+    {
+        Index index;
+        unordered_map<QString, int> copies;
+        for(const DataNode &node : file)
+        {
+            QString key = Text(node);
+            int copy = ++copies[key];
+            if(copy > 1)
+                key += " #" + QString::number(copy);
+            Item &item = index.Get(key);
+            item.nodes.push_back(&node);
+            item.hash = node.Hash();
+        }
+        return index;
+    }
+
+    Index Fields(const Item &entity)
+    {
+        Index index;
+        for(const DataNode &child : *entity.nodes.front())
+        {
+            QString key = child.Token(0);
+            if(child.Size() >= 2 && find(begin(NAMED_FIELDS), end(NAMED_FIELDS), key) != end(NAMED_FIELDS))
+                key += " " + Quoted(child.Token(1));
+            Item &item = index.Get(key);
+            item.nodes.push_back(&child);
+            item.hash = (item.hash ^ child.Hash()) * FNV_PRIME;
+        }
+        return index;
+    }
+
+    void DiffFields(const Item &before, const Item &after, vector<Change> &changes)
+    {
+        Index old = Fields(before);
+        Index now = Fields(after);
+        for(const Item &field : old.items)
+        {
+            const Item *other = now.Find(field.key);
+            if(!other)
+                changes.push_back({Change::REMOVED, before.key, field.key, Summary(&field), QString()});
+            else if(other->hash != field.hash)
+                changes.push_back({Change::CHANGED, before.key, field.key, Summary(&field), Summary(other)});
+        }
+        for(const Item &field : now.items)
+            if(!old.Find(field.key))
+                changes.push_back({Change::ADDED, before.key, field.key, QString(), Summary(&field)});
+    }
+
+    // Decide which side's version of an item a three-way merge should keep.
+    // A missing item is one that was removed (or never added).
+    enum Pick {
+        OURS,
+        THEIRS,
+        CONFLICT
+    };
+    bool Same(const Item *a, const Item *b)
+    {
+        return a ? (b && a->hash == b->hash) : !b;
+    }
+    Pick Choose(const Item *base, const Item *ours, const Item *theirs)
+    {
+        if(Same(ours, theirs) || Same(base, theirs))
+            return OURS;
+        if(Same(base, ours))
+            return THEIRS;
+        return CONFLICT;
+    }
+
+    void Write(DataWriter &out, const Item *item)
+    {
+        if(item)
+            for(const DataNode *node : item->nodes)
+                out.Write(*node);
+    }
+
+    // Merge an entity that both sides changed, one field at a time.
+    void MergeFields(const Item *base, const Item &ours, const Item &theirs, DataWriter &out,
+        vector<Conflict> &conflicts)
+    {
+        Index baseFields = (base ? Fields(*base) : Index());
+        Index ourFields = Fields(ours);
+        Index theirFields = Fields(theirs);
+
+        const DataNode &root = *ours.nodes.front();
+        for(int i = 0; i < root.Size(); ++i)
+            out.WriteToken(root.Token(i));
+        out.Write();
+
+        auto merge = [&](const QString &key)
+        {
+            const Item *ourField = ourFields.Find(key);
+            const Item *theirField = theirFields.Find(key);
+            Pick pick = Choose(baseFields.Find(key), ourField, theirField);
+            if(pick == CONFLICT)
+                conflicts.push_back({ours.key, key, Summary(ourField), Summary(theirField)});
+            Write(out, pick == THEIRS ? theirField : ourField);
+        };
+        out.BeginChild();
+        {
+            for(const Item &field : ourFields.items)
+                merge(field.key);
+            for(const Item &field : theirFields.items)
+                if(!ourFields.Find(field.key))
+                    merge(field.key);
+        }
+        out.EndChild();
+    }
+}
+
+
+
+// List every difference between two files, in the order of the entities
+// and fields in the "before" file, followed by everything that was added.
+vector<Change> MapDiff::Diff(const DataFile &before, const DataFile &after)
+{
+    const DataFile *files[2] = {&before, &after};
+    Index indices[2];
+    ParallelFor(2, [&](int i)
+    {
+        indices[i] = Entities(*files[i]);
+    });
+    const Index &old = indices[0];
+    const Index &now = indices[1];
+
+    // Only entities whose hashes differ need to be compared field by field.
+    vector<Change> changes;
+    if(before.Comments() != after.Comments())
+        changes.push_back({Change::CHANGED, "comments", QString(), CommentSummary(before.Comments()),
+            CommentSummary(after.Comments())});
+    for(const Item &entity : old.items)
+    {
+        const Item *other = now.Find(entity.key);
+        if(!other)
+            changes.push_back({Change::REMOVED, entity.key, QString(), Summary(&entity), QString()});
+        else if(other->hash != entity.hash)
+            DiffFields(entity, *other, changes);
+    }
+    for(const Item &entity : now.items)
+        if(!old.Find(entity.key))
+            changes.push_back({Change::ADDED, entity.key, QString(), QString(), Summary(&entity)});
+    return changes;
+}
+
+
+
+// Merge the changes made in "ours" and "theirs" since "base," writing the
+// result. Any field that only one side changed takes that side's version.
+// The entities are in our order, followed by any that only they added.
+vector<Conflict> MapDiff::Merge(const DataFile &base, const DataFile &ours, const DataFile &theirs,
+    DataWriter &out)
+{
+    const DataFile *files[3] = {&base, &ours, &theirs};
+    Index indices[3];
+    ParallelFor(3, [&](int i)
+    {
+        indices[i] = Entities(*files[i]);
+    });
+    const Index &baseEntities = indices[0];
+    const Index &ourEntities = indices[1];
+    const Index &theirEntities = indices[2];
+
+    vector<Conflict> conflicts;
+    auto merge = [&](const QString &key)
+    {
+        const Item *baseEntity = baseEntities.Find(key);
+        const Item *ourEntity = ourEntities.Find(key);
+        const Item *theirEntity = theirEntities.Find(key);
+        Pick pick = Choose(baseEntity, ourEntity, theirEntity);
+        if(pick == CONFLICT && ourEntity && theirEntity)
+        {
+            MergeFields(baseEntity, *ourEntity, *theirEntity, out, conflicts);
+            out.Write();
+            return;
+        }
+        // If one side removed an entity the other changed, keep our version.
+        if(pick == CONFLICT)
+            conflicts.push_back({key, QString(), Summary(ourEntity), Summary(theirEntity)});
+        const Item *entity = (pick == THEIRS ? theirEntity : ourEntity);
+        if(entity)
+        {
+            Write(out, entity);
+            out.Write();
+        }
+    };
+
+    // The comments are one block, which takes whichever side's version
+    // changed, like an entity.
+    const QString *comments = &ours.Comments();
+    if(base.Comments() == ours.Comments())
+        comments = &theirs.Comments();
+    else if(base.Comments() != theirs.Comments() && ours.Comments() != theirs.Comments())
+        conflicts.push_back({"comments", QString(), CommentSummary(ours.Comments()),
+            CommentSummary(theirs.Comments())});
+    out.WriteRaw(*comments);
+    out.Write();
+    for(const Item &entity : ourEntities.items)
+        merge(entity.key);
+    for(const Item &entity : theirEntities.items)
+        if(!ourEntities.Find(entity.key))
+            merge(entity.key);
+    return conflicts;
+}
+
+
+
+QString MapDiff::Describe(const Change &change)
+{
+    if(change.field.isEmpty() && change.kind != Change::CHANGED)
+        return change.entity + (change.kind == Change::ADDED ? ": added" : ": removed");
+    if(change.kind == Change::ADDED)
+        return change.entity + ": added " + change.after;
+    if(change.kind == Change::REMOVED)
+        return change.entity + ": removed " + change.before;
+    return change.entity + ": changed " + change.before + " -> " + change.after;
+}
+
+
+
+QString MapDiff::Describe(const Conflict &conflict)
+{
+    QString text = conflict.entity + ": ";
+    if(!conflict.field.isEmpty())
+        text += conflict.field + ": ";
+    text += "ours " + (conflict.ours.isEmpty() ? QString("(removed)") : conflict.ours);
+    text += ", theirs " + (conflict.theirs.isEmpty() ? QString("(removed)") : conflict.theirs);
+    return text;
+}
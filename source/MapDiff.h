@@ -0,0 +1,81 @@
+/* MapDiff.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MAPDIFF_H_
+#define MAPDIFF_H_
+
+#include <QString>
+
+#include <vector>
+
+class DataFile;
+class DataWriter;
+
+
+
+// Class for comparing and merging map files by their structure instead of by
+// their text. Each top level node (a system, planet, galaxy, or anything else)
+// is an "entity," matched by its name, and each of its children is a "field,"
+// matched by its first token. Fields that can be repeated with different names,
+// like links, prices, and fleets, are also matched by their second token, so
+// they are compared as sets; other repeated fields (e.g. stellar objects or
+// lines of a description) are compared as one ordered list. Entities and fields
+// are hashed, so identical ones are skipped without being compared in detail.
+// The comments are treated as one more entity, which is written at the top of
+// the merged file, so any comments that came after the first node would be
+// moved there; see DataFile::HasInteriorComments().
+class MapDiff {
+public:
+    struct Change {
+        enum Kind {
+            ADDED,
+            REMOVED,
+            CHANGED
+        };
+        Kind kind;
+        // E.g. "system Sol".
+        QString entity;
+        // E.g. "link Alpha Centauri", or empty if the whole entity was added
+        // or removed.
+        QString field;
+        // The first line of the field before and after the change.
+        QString before;
+        QString after;
+    };
+    // A field (or entity) that both sides of a merge changed in different
+    // ways. The merge keeps "our" version of it.
+    struct Conflict {
+        QString entity;
+        QString field;
+        QString ours;
+        QString theirs;
+    };
+
+
+public:
+    // List every difference between two files, in the order of the entities
+    // and fields in the "before" file, followed by everything that was added.
+    static std::vector<Change> Diff(const DataFile &before, const DataFile &after);
+    // Merge the changes made in "ours" and "theirs" since "base," writing the
+    // result. Any field that only one side changed takes that side's version.
+    // The entities are in our order, followed by any that only they added,
+    // and the comments are merged as a single block.
+    static std::vector<Conflict> Merge(const DataFile &base, const DataFile &ours,
+        const DataFile &theirs, DataWriter &out);
+
+    static QString Describe(const Change &change);
+    static QString Describe(const Conflict &conflict);
+};
+
+
+
+#endif
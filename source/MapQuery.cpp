@@ -0,0 +1,459 @@
+/* MapQuery.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MapQuery.h"
+
+#include "Map.h"
+#include "Planet.h"
+#include "StellarObject.h"
+#include "System.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+using namespace std;
+
+namespace {
+    enum Op {
+        EQUAL,
+        NOT_EQUAL,
+        LESS,
+        LESS_EQUAL,
+        GREATER,
+        GREATER_EQUAL,
+        CONTAINS
+    };
+    // The operators, in the same order.
+    const char *OPERATORS[] = {"=", "!=", "<", "<=", ">", ">=", "~"};
+
+    const char *KEYWORDS[] = {"not", "no", "name", "government", "x", "y", "links", "planets",
+        "trade", "attribute", "attributes", "hidden", "spaceport", "shipyard", "outfitter"};
+
+    struct Token {
+        QString text;
+        bool isQuoted;
+    };
+
+    bool IsOperator(QChar c)
+    {
+        return (c == '=' || c == '!' || c == '<' || c == '>' || c == '~');
+    }
+
+    // Split a query into words, quoted strings, and operators. Operators do not
+    // need spaces around them.
+    vector<Token> Tokenize(const QString &query)
+    {
+        vector<Token> tokens;
+        int i = 0;
+        int length = query.length();
+        while(i < length)
+        {
+            if(query[i].isSpace())
+            {
+                ++i;
+                continue;
+            }
+            Token token = {QString(), query[i] == '"'};
+            if(token.isQuoted)
+            {
+                for(++i; i < length && query[i] != '"'; ++i)
+                    token.text += query[i];
+                ++i;
+            }
+            else if(IsOperator(query[i]))
+                while(i < length && IsOperator(query[i]))
+                    token.text += query[i++];
+            else
+                while(i < length && !query[i].isSpace() && !IsOperator(query[i]) && query[i] != '"')
+                    token.text += query[i++];
+            tokens.push_back(token);
+        }
+        return tokens;
+    }
+
+    bool IsWord(const Token &token, const char *word)
+    {
+        return !token.isQuoted && !token.text.compare(word, Qt::CaseInsensitive);
+    }
+
+    bool IsKeyword(const Token &token)
+    {
+        for(const char *word : KEYWORDS)
+            if(IsWord(token, word))
+                return true;
+        return false;
+    }
+
+    // Get the operator the given token is, or -1 if it is not one.
+    int GetOperator(const Token &token)
+    {
+        if(token.isQuoted)
+            return -1;
+        auto it = find(begin(OPERATORS), end(OPERATORS), token.text);
+        return (it == end(OPERATORS) ? -1 : static_cast<int>(it - begin(OPERATORS)));
+    }
+
+    bool Compare(double value, Op op, double target)
+    {
+        // A missing value (e.g. a price in a system with no market) never
+        // matches anything.
+        if(std::isnan(value))
+            return false;
+        switch(op)
+        {
+            case EQUAL:
+                return value == target;
+            case NOT_EQUAL:
+                return value != target;
+            case LESS:
+                return value < target;
+            case LESS_EQUAL:
+                return value <= target;
+            case GREATER:
+                return value > target;
+            case GREATER_EQUAL:
+                return value >= target;
+            default:
+                return false;
+        }
+    }
+
+    bool Compare(const QString &value, Op op, const QString &target)
+    {
+        if(op == EQUAL)
+            return !value.compare(target, Qt::CaseInsensitive);
+        if(op == NOT_EQUAL)
+            return value.compare(target, Qt::CaseInsensitive) != 0;
+        return op == CONTAINS && value.contains(target, Qt::CaseInsensitive);
+    }
+
+    // Find a column by name, ignoring case.
+    template <class Column>
+    const Column *FindColumn(const map<QString, Column> &columns, const QString &name)
+    {
+        auto it = columns.find(name);
+        if(it != columns.end())
+            return &it->second;
+        for(const auto &column : columns)
+            if(!column.first.compare(name, Qt::CaseInsensitive))
+                return &column.second;
+        return nullptr;
+    }
+}
+
+
+
+// One condition of a query, with the column it tests.
+struct MapQuery::Clause {
+    bool negate = false;
+    Op op = EQUAL;
+    // At most one of these is set. If none of them are, nothing matches.
+    const vector<double> *numbers = nullptr;
+    const vector<char> *flags = nullptr;
+    const vector<QString> *strings = nullptr;
+    bool isGovernment = false;
+
+    double number = 0.;
+    QString text;
+};
+
+
+
+MapQuery::MapQuery(const Map &mapData)
+{
+    size_t count = mapData.Systems().size();
+    map<QString, int> governmentIds;
+    for(const auto &it : mapData.Systems())
+    {
+        const System &system = it.second;
+        size_t row = names.size();
+        names.push_back(it.first);
+
+        if(system.Government().isEmpty())
+            governments.push_back(-1);
+        else
+        {
+            auto id = governmentIds.emplace(system.Government(), governmentNames.size());
+            if(id.second)
+                governmentNames.push_back(system.Government());
+            governments.push_back(id.first->second);
+        }
+
+        x.push_back(system.Position().x());
+        y.push_back(system.Position().y());
+        links.push_back(system.Links().size());
+        hidden.push_back(system.Hidden());
+        for(const auto &price : system.Trades())
+        {
+            vector<double> &column = trade[price.first];
+            if(column.empty())
+                column.resize(count, numeric_limits<double>::quiet_NaN());
+            column[row] = price.second;
+        }
+
+        int named = 0;
+        bool hasSpaceport = false;
+        bool hasShipyard = false;
+        bool hasOutfitter = false;
+        for(const StellarObject &object : system.Objects())
+        {
+            if(object.GetPlanet().isEmpty())
+                continue;
+            ++named;
+            auto planet = mapData.Planets().find(object.GetPlanet());
+            if(planet == mapData.Planets().end())
+                continue;
+            hasSpaceport |= planet->second.HasSpaceport();
+            hasShipyard |= planet->second.HasShipyard();
+            hasOutfitter |= planet->second.HasOutfitter();
+            for(const QString &attribute : planet->second.Attributes())
+            {
+                vector<char> &column = attributes[attribute];
+                if(column.empty())
+                    column.resize(count);
+                column[row] = true;
+            }
+        }
+        planets.push_back(named);
+        spaceport.push_back(hasSpaceport);
+        shipyard.push_back(hasShipyard);
+        outfitter.push_back(hasOutfitter);
+    }
+}
+
+
+
+// Find the systems that match the query, in order by name. If the query
+// cannot be understood, return false and describe the problem instead.
+bool MapQuery::Find(const QString &query, vector<QString> &matches, QString &error) const
+{
+    matches.clear();
+    vector<Clause> clauses;
+    if(!Parse(query, clauses, error))
+        return false;
+
+    vector<char> mask(names.size(), true);
+    for(const Clause &clause : clauses)
+        Apply(clause, mask);
+    for(unsigned i = 0; i < mask.size(); ++i)
+        if(mask[i])
+            matches.push_back(names[i]);
+    return true;
+}
+
+
+
+// Describe the query syntax, one line per kind of clause.
+const char *MapQuery::Help()
+{
+    return "<text>: systems with the given text in their names.\n"
+        "name = <name>, name ~ <text>: systems with that name, or containing that text.\n"
+        "government = <name>, government ~ <text>: systems with that government.\n"
+        "x, y, links, or planets <op> <number>: position, number of links, or number of\n"
+        "    named stellar objects. <op> is one of =, !=, <, <=, >, or >=.\n"
+        "trade <commodity> <op> <price>: systems with a price for that commodity.\n"
+        "attribute <name>: systems with a planet that has that attribute.\n"
+        "hidden, spaceport, shipyard, outfitter: systems that are hidden, or have a\n"
+        "    planet with a spaceport, shipyard, or outfitter.\n"
+        "Join conditions with \"and\", and put \"not\" or \"no\" before a condition to\n"
+        "reverse it. Use quotation marks around names that are also keywords.\n";
+}
+
+
+
+bool MapQuery::Parse(const QString &query, vector<Clause> &clauses, QString &error) const
+{
+    vector<Token> tokens = Tokenize(query);
+    if(tokens.empty())
+    {
+        error = "The query is empty.";
+        return false;
+    }
+    // Plain text that does not start with a keyword is a search by name.
+    if(!IsKeyword(tokens.front()))
+    {
+        QString text;
+        for(const Token &token : tokens)
+            text += (text.isEmpty() ? "" : " ") + token.text;
+        Clause clause;
+        clause.strings = &names;
+        clause.op = CONTAINS;
+        clause.text = text;
+        clauses.push_back(clause);
+        return true;
+    }
+
+    unsigned i = 0;
+    auto isEnd = [&tokens, &i]()
+    {
+        return i == tokens.size() || IsWord(tokens[i], "and");
+    };
+    // Names may be several words long, ending at an operator or the end of
+    // the clause.
+    auto readName = [&tokens, &i, &isEnd]()
+    {
+        QString name;
+        for( ; !isEnd() && GetOperator(tokens[i]) < 0; ++i)
+            name += (name.isEmpty() ? "" : " ") + tokens[i].text;
+        return name;
+    };
+
+    while(true)
+    {
+        Clause clause;
+        if(IsWord(tokens[i], "not") || IsWord(tokens[i], "no"))
+        {
+            clause.negate = true;
+            if(++i == tokens.size())
+            {
+                error = "Expected a condition after \"" + tokens[i - 1].text + "\".";
+                return false;
+            }
+        }
+
+        QString field = tokens[i++].text.toLower();
+        QString subject;
+        if(field == "hidden")
+            clause.flags = &hidden;
+        else if(field == "spaceport")
+            clause.flags = &spaceport;
+        else if(field == "shipyard")
+            clause.flags = &shipyard;
+        else if(field == "outfitter")
+            clause.flags = &outfitter;
+        else if(field == "attribute" || field == "attributes")
+        {
+            subject = readName();
+            if(subject.isEmpty())
+            {
+                error = "Expected an attribute name after \"" + field + "\".";
+                return false;
+            }
+            clause.flags = FindColumn(attributes, subject);
+        }
+        else
+        {
+            bool isNumber = true;
+            if(field == "name")
+            {
+                clause.strings = &names;
+                isNumber = false;
+            }
+            else if(field == "government")
+            {
+                clause.isGovernment = true;
+                isNumber = false;
+            }
+            else if(field == "x")
+                clause.numbers = &x;
+            else if(field == "y")
+                clause.numbers = &y;
+            else if(field == "links")
+                clause.numbers = &links;
+            else if(field == "planets")
+                clause.numbers = &planets;
+            else if(field == "trade")
+            {
+                subject = readName();
+                clause.numbers = FindColumn(trade, subject);
+                if(!clause.numbers)
+                {
+                    error = "No system has a price for \"" + subject + "\".";
+                    return false;
+                }
+            }
+            else
+            {
+                error = "Unknown field \"" + tokens[i - 1].text + "\".";
+                return false;
+            }
+
+            int op = (i < tokens.size() ? GetOperator(tokens[i]) : -1);
+            bool isValid = (op >= 0 && (isNumber ? op != CONTAINS : op <= NOT_EQUAL || op == CONTAINS));
+            if(!isValid)
+            {
+                error = "Expected " + QString(isNumber ? "=, !=, <, <=, >, or >=" : "=, !=, or ~")
+                    + " after \"" + tokens[i - 1].text + "\".";
+                return false;
+            }
+            clause.op = static_cast<Op>(op);
+            ++i;
+
+            clause.text = readName();
+            bool isValue = !clause.text.isEmpty();
+            if(isValue && isNumber)
+                clause.number = clause.text.toDouble(&isValue);
+            if(!isValue)
+            {
+                error = "Expected " + QString(isNumber ? "a number" : "a value") + " after \""
+                    + OPERATORS[op] + "\".";
+                return false;
+            }
+        }
+        clauses.push_back(clause);
+
+        if(i == tokens.size())
+            return true;
+        if(!IsWord(tokens[i], "and"))
+        {
+            error = "Expected \"and\" before \"" + tokens[i].text + "\".";
+            return false;
+        }
+        if(++i == tokens.size())
+        {
+            error = "Expected another condition after \"and\".";
+            return false;
+        }
+    }
+}
+
+
+
+// Clear the mask for every system that does not match the given clause.
+void MapQuery::Apply(const Clause &clause, vector<char> &mask) const
+{
+    auto filter = [&clause, &mask](auto test)
+    {
+        for(unsigned i = 0; i < mask.size(); ++i)
+            if(mask[i] && test(i) == clause.negate)
+                mask[i] = false;
+    };
+
+    if(clause.numbers)
+    {
+        const vector<double> &column = *clause.numbers;
+        filter([&](unsigned i) { return Compare(column[i], clause.op, clause.number); });
+    }
+    else if(clause.flags)
+    {
+        const vector<char> &column = *clause.flags;
+        filter([&](unsigned i) { return column[i] != 0; });
+    }
+    else if(clause.strings)
+    {
+        const vector<QString> &column = *clause.strings;
+        filter([&](unsigned i) { return Compare(column[i], clause.op, clause.text); });
+    }
+    else if(clause.isGovernment)
+    {
+        // Compare each government name once, rather than once per system.
+        vector<char> isMatch(governmentNames.size());
+        for(unsigned id = 0; id < governmentNames.size(); ++id)
+            isMatch[id] = Compare(governmentNames[id], clause.op, clause.text);
+        bool isNoneMatch = Compare(QString(), clause.op, clause.text);
+        filter([&](unsigned i) { return governments[i] < 0 ? isNoneMatch : isMatch[governments[i]] != 0; });
+    }
+    else
+        filter([](unsigned) { return false; });
+}
@@ -0,0 +1,75 @@
+/* MapQuery.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MAPQUERY_H_
+#define MAPQUERY_H_
+
+#include <QString>
+
+#include <map>
+#include <vector>
+
+class Map;
+
+
+
+// Class for finding the systems that match a query like "government = Republic
+// and trade Food > 400 and no shipyard". The map is copied into one column per
+// field, with one entry per system, so each clause of a query is a single pass
+// over one column. Planet data (shipyards, outfitters, attributes, etc.) counts
+// for the system the planet is in. The columns are not updated if the map
+// changes, so a MapQuery that is kept between searches must be rebuilt
+// whenever the map's Revision() changes.
+class MapQuery {
+public:
+    explicit MapQuery(const Map &mapData);
+
+    // Find the systems that match the query, in order by name. If the query
+    // cannot be understood, return false and describe the problem instead.
+    bool Find(const QString &query, std::vector<QString> &matches, QString &error) const;
+
+    // Describe the query syntax, one line per kind of clause.
+    static const char *Help();
+
+
+private:
+    struct Clause;
+    bool Parse(const QString &query, std::vector<Clause> &clauses, QString &error) const;
+    // Clear the mask for every system that does not match the given clause.
+    void Apply(const Clause &clause, std::vector<char> &mask) const;
+
+
+private:
+    std::vector<QString> names;
+    // Each system's government, as an index into the list of governments, or
+    // -1 if it has none.
+    std::vector<int> governments;
+    std::vector<QString> governmentNames;
+    // The number columns: position, links, and named objects.
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> links;
+    std::vector<double> planets;
+    // Prices, by commodity. A system with no price for a commodity is NaN.
+    std::map<QString, std::vector<double>> trade;
+    // The yes or no columns.
+    std::vector<char> hidden;
+    std::vector<char> spaceport;
+    std::vector<char> shipyard;
+    std::vector<char> outfitter;
+    // Which systems have a planet with each attribute.
+    std::map<QString, std::vector<char>> attributes;
+};
+
+
+
+#endif
@@ -0,0 +1,181 @@
+/* OrbitPropagator.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "OrbitPropagator.h"
+
+#include "ParallelFor.h"
+#include "System.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+    // Objects are handed to the worker threads in blocks of this size.
+    const size_t BLOCK = 16384;
+    // Beyond this many orbits, the fast way of dropping the whole orbits would
+    // overflow an int.
+    const double MAX_TURNS = 1 << 30;
+
+    const float HALF_PI = 1.57079632679f;
+    // Minimax polynomials for sin(r) and cos(r) on [-pi/4, pi/4], accurate to
+    // about one unit in the last place of a float.
+    const float S1 = -1.6666654611e-1f;
+    const float S2 = 8.3321608736e-3f;
+    const float S3 = -1.9515295891e-4f;
+    const float C1 = 4.166664568298827e-2f;
+    const float C2 = -1.388731625493765e-3f;
+    const float C3 = 2.443315711809948e-5f;
+
+    // Find how far around its orbit each object is, dropping any whole orbits
+    // it has completed (so the result is between -1 and 1). This is done in
+    // double precision, because the number of orbits may be large.
+    void Turns(const double *frequency, const double *phase, double day, float *turns, size_t count)
+    {
+        for(size_t i = 0; i < count; ++i)
+        {
+            double value = day * frequency[i] + phase[i];
+            turns[i] = value - static_cast<int>(value);
+        }
+    }
+
+    // The same, for dates so far out that the number of orbits would not fit in
+    // an int.
+    void SlowTurns(const double *frequency, const double *phase, double day, float *turns, size_t count)
+    {
+        for(size_t i = 0; i < count; ++i)
+            turns[i] = fmod(day * frequency[i] + phase[i], 1.);
+    }
+
+    // Convert each object's fraction of an orbit to its offset from its parent.
+    // The angle is split into a quarter turn (found by truncating a positive
+    // number, to avoid the library's rounding functions) and a remainder of at
+    // most an eighth of a turn. The quarter turn then decides which polynomial
+    // gives the sine and which the cosine, and their signs. Everything here is
+    // arithmetic rather than branches, so that the loop is vectorized.
+    void Positions(const float *turns, const float *distance, float *x, float *y, size_t count)
+    {
+        for(size_t i = 0; i < count; ++i)
+        {
+            float quarters = turns[i] * 4.f;
+            int quadrant = static_cast<int>(quarters + 4.5f) - 4;
+            float r = (quarters - quadrant) * HALF_PI;
+            float r2 = r * r;
+            float s = r + r * r2 * (S1 + r2 * (S2 + r2 * S3));
+            float c = 1.f - .5f * r2 + r2 * r2 * (C1 + r2 * (C2 + r2 * C3));
+
+            float swap = quadrant & 1;
+            float sine = (s + swap * (c - s)) * (1 - 2 * ((quadrant >> 1) & 1));
+            float cosine = (c + swap * (s - c)) * (1 - 2 * (((quadrant + 1) >> 1) & 1));
+            x[i] = distance[i] * sine;
+            y[i] = -distance[i] * cosine;
+        }
+    }
+}
+
+
+
+void OrbitPropagator::Clear()
+{
+    frequency.clear();
+    phase.clear();
+    distance.clear();
+    parent.clear();
+    maxFrequency = 0.;
+    turns.clear();
+    x.clear();
+    y.clear();
+}
+
+
+
+// Add all the objects in the given system, and return the index of the
+// first one.
+size_t OrbitPropagator::Add(const System &system)
+{
+    size_t first = distance.size();
+    for(const System::Orbit &orbit : system.Orbits(0))
+    {
+        frequency.push_back(orbit.period ? 1. / orbit.period : 0.);
+        phase.push_back(orbit.offset / 360.);
+        distance.push_back(orbit.distance);
+        maxFrequency = max(maxFrequency, fabs(frequency.back()));
+    }
+    for(const StellarObject &object : system.Objects())
+        parent.push_back(object.Parent() >= 0 ? static_cast<int>(first) + object.Parent() : -1);
+    return first;
+}
+
+
+
+// Find every object's position on the given day.
+void OrbitPropagator::Propagate(double day)
+{
+    this->day = day;
+    size_t count = distance.size();
+    turns.resize(count);
+    x.resize(count);
+    y.resize(count);
+
+    bool isFar = (fabs(day) * maxFrequency + 1. >= MAX_TURNS);
+    int blocks = (count + BLOCK - 1) / BLOCK;
+    ParallelFor(blocks, [&](int block)
+    {
+        size_t first = block * BLOCK;
+        size_t size = min(BLOCK, count - first);
+        if(isFar)
+            SlowTurns(&frequency[first], &phase[first], day, &turns[first], size);
+        else
+            Turns(&frequency[first], &phase[first], day, &turns[first], size);
+        Positions(&turns[first], &distance[first], &x[first], &y[first], size);
+    });
+
+    // Every parent comes before its children, so by the time each object is
+    // reached its parent is already in its final position.
+    for(size_t i = 0; i < count; ++i)
+        if(parent[i] >= 0)
+        {
+            x[i] += x[parent[i]];
+            y[i] += y[parent[i]];
+        }
+}
+
+
+
+// Move the objects of a system that was added at the given index to the
+// positions found by the last call to Propagate().
+void OrbitPropagator::Apply(System &system, size_t first) const
+{
+    system.SetPositions(day, &x[first], &y[first]);
+}
+
+
+
+size_t OrbitPropagator::Size() const
+{
+    return distance.size();
+}
+
+
+
+const float *OrbitPropagator::X() const
+{
+    return x.data();
+}
+
+
+
+const float *OrbitPropagator::Y() const
+{
+    return y.data();
+}
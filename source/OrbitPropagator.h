@@ -0,0 +1,66 @@
+/* OrbitPropagator.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef ORBITPROPAGATOR_H_
+#define ORBITPROPAGATOR_H_
+
+#include <cstddef>
+#include <vector>
+
+class System;
+
+
+
+// Class for computing where stellar objects are on a given day, for any number
+// of systems at once. The orbits are packed into flat arrays, so that finding
+// each object's angle and then its sine and cosine are each one simple loop
+// (using a polynomial rather than the library functions), which the compiler
+// can vectorize. Large batches are also split across threads.
+class OrbitPropagator {
+public:
+    void Clear();
+    // Add all the objects in the given system, and return the index of the
+    // first one.
+    size_t Add(const System &system);
+
+    // Find every object's position on the given day.
+    void Propagate(double day);
+
+    // Move the objects of a system that was added at the given index to the
+    // positions found by the last call to Propagate().
+    void Apply(System &system, size_t first) const;
+
+    size_t Size() const;
+    const float *X() const;
+    const float *Y() const;
+
+
+private:
+    // Each orbit is given as the number of orbits per day and the fraction of
+    // an orbit it starts at, its radius, and the index of the object it orbits
+    // around (or -1 if none).
+    std::vector<double> frequency;
+    std::vector<double> phase;
+    std::vector<float> distance;
+    std::vector<int> parent;
+    double maxFrequency = 0.;
+    double day = 0.;
+
+    // The fraction of an orbit each object has completed, and the results.
+    std::vector<float> turns;
+    std::vector<float> x;
+    std::vector<float> y;
+};
+
+
+
+#endif
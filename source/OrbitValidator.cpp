@@ -0,0 +1,62 @@
+/* OrbitValidator.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "OrbitValidator.h"
+
+#include "Map.h"
+#include "ParallelFor.h"
+#include "StellarObject.h"
+
+#include <cmath>
+
+using namespace std;
+
+
+
+// Check every system, and list the ones with errors in order by name.
+vector<OrbitValidator::Result> OrbitValidator::Check(const Map &map)
+{
+    vector<const System *> systems;
+    for(const auto &it : map.Systems())
+        systems.push_back(&it.second);
+
+    // Each system only caches its own occupied rings, so each one can be
+    // checked on a different thread.
+    vector<vector<System::SpacingError>> errors(systems.size());
+    ParallelFor(systems.size(), [&](int i)
+    {
+        errors[i] = systems[i]->SpacingErrors();
+    });
+
+    vector<Result> results;
+    for(unsigned i = 0; i < systems.size(); ++i)
+        if(!errors[i].empty())
+            results.push_back({systems[i]->TrueName(), std::move(errors[i])});
+    return results;
+}
+
+
+
+// Describe an error in the given system in words.
+QString OrbitValidator::Describe(const System &system, const System::SpacingError &error)
+{
+    const StellarObject &object = system.Objects()[error.object];
+    QString name = object.GetPlanet().isEmpty() ? object.Sprite() : object.GetPlanet();
+    QString text = system.TrueName() + ": " + (name.isEmpty() ? "object " + QString::number(error.object) : name);
+    if(error.kind == System::SpacingError::STAR_GAP)
+        text += " is too close to the stars";
+    else if(error.kind == System::SpacingError::ZONE_GAP)
+        text += " is too close to the planet inside it";
+    else
+        text += " is too close to the object it orbits, or the moon inside it";
+    return text + " (by " + QString::number(lround(error.shortfall)) + ").";
+}
@@ -0,0 +1,47 @@
+/* OrbitValidator.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef ORBITVALIDATOR_H_
+#define ORBITVALIDATOR_H_
+
+#include "System.h"
+
+#include <QString>
+
+#include <vector>
+
+class Map;
+
+
+
+// Class for checking every system in the map for stellar objects that break
+// the spacing rules, which are otherwise only enforced while dragging. Each
+// system is checked on its own, so they are spread across worker threads.
+class OrbitValidator {
+public:
+    // All the spacing errors in one system.
+    struct Result {
+        QString system;
+        std::vector<System::SpacingError> errors;
+    };
+
+
+public:
+    // Check every system, and list the ones with errors in order by name.
+    static std::vector<Result> Check(const Map &map);
+    // Describe an error in the given system in words.
+    static QString Describe(const System &system, const System::SpacingError &error);
+};
+
+
+
+#endif
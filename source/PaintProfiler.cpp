@@ -0,0 +1,207 @@
+/* PaintProfiler.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "PaintProfiler.h"
+
+#include "SpriteSet.h"
+
+#include <QFile>
+#include <QPainter>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+using namespace std;
+
+namespace {
+    // Percentiles are computed over this many of the most recent frames.
+    static const int WINDOW = 240;
+
+    static const char *COUNTER_NAME[PaintProfiler::COUNTER_COUNT] = {
+        "links",
+        "systems",
+        "sprites"
+    };
+
+    bool enabled = false;
+    unique_ptr<QFile> logFile;
+    unique_ptr<QTextStream> logStream;
+
+    QString Percent(int hits, int misses)
+    {
+        int total = hits + misses;
+        if(!total)
+            return "-";
+        return QString::number(100. * hits / total, 'f', 1) + "% of " + QString::number(total);
+    }
+}
+
+
+
+PaintProfiler::PaintProfiler(const QString &view)
+    : view(view)
+{
+}
+
+
+
+// Turn profiling on or off for all views.
+void PaintProfiler::SetEnabled(bool isEnabled)
+{
+    enabled = isEnabled;
+}
+
+
+
+bool PaintProfiler::IsEnabled()
+{
+    return enabled;
+}
+
+
+
+// Write one line per painted frame to the given file. A path of "-" means
+// standard error; an empty path turns the log off.
+void PaintProfiler::SetLogFile(const QString &path)
+{
+    logStream.reset();
+    logFile.reset();
+    if(path.isEmpty())
+        return;
+
+    logFile.reset(new QFile(path));
+    bool isOpen = (path == "-") ? logFile->open(stderr, QFile::WriteOnly)
+        : logFile->open(QFile::WriteOnly | QFile::Truncate | QFile::Text);
+    if(isOpen)
+        logStream.reset(new QTextStream(logFile.get()));
+    else
+        logFile.reset();
+}
+
+
+
+void PaintProfiler::Begin()
+{
+    isActive = enabled || logStream;
+    if(!isActive)
+        return;
+
+    fill(counts, counts + COUNTER_COUNT, 0);
+    cacheHits = 0;
+    cacheMisses = 0;
+    spriteHits = -SpriteSet::CacheHits();
+    spriteMisses = -SpriteSet::CacheMisses();
+    timer.start();
+}
+
+
+
+void PaintProfiler::Count(Counter counter, int count)
+{
+    counts[counter] += count;
+}
+
+
+
+// Record whether a view-level cache lookup hit or missed.
+void PaintProfiler::Cache(bool hit)
+{
+    cacheHits += hit;
+    cacheMisses += !hit;
+}
+
+
+
+void PaintProfiler::End()
+{
+    if(!isActive)
+        return;
+    isActive = false;
+
+    lastTime = timer.nsecsElapsed() * .000001;
+    spriteHits += SpriteSet::CacheHits();
+    spriteMisses += SpriteSet::CacheMisses();
+    ++frame;
+
+    if(static_cast<int>(times.size()) < WINDOW)
+        times.push_back(lastTime);
+    else
+        times[next] = lastTime;
+    next = (next + 1) % WINDOW;
+
+    if(!logStream)
+        return;
+
+    *logStream << "paint view=" << view << " frame=" << frame
+        << " ms=" << QString::number(lastTime, 'f', 3)
+        << " p50=" << QString::number(Percentile(.5), 'f', 3)
+        << " p99=" << QString::number(Percentile(.99), 'f', 3);
+    for(int i = 0; i < COUNTER_COUNT; ++i)
+        *logStream << ' ' << COUNTER_NAME[i] << '=' << counts[i];
+    *logStream << " sprite_hits=" << spriteHits << " sprite_misses=" << spriteMisses
+        << " cache_hits=" << cacheHits << " cache_misses=" << cacheMisses << '\n';
+    logStream->flush();
+}
+
+
+
+// Draw the overlay in the top left corner of the painter's device.
+void PaintProfiler::Draw(QPainter &painter) const
+{
+    if(!enabled || !frame)
+        return;
+
+    QStringList lines;
+    lines << view + ": " + QString::number(lastTime, 'f', 2) + " ms (p50 "
+        + QString::number(Percentile(.5), 'f', 2) + ", p99 "
+        + QString::number(Percentile(.99), 'f', 2) + ")";
+    QString countLine;
+    for(int i = 0; i < COUNTER_COUNT; ++i)
+        countLine += QString(COUNTER_NAME[i]) + " " + QString::number(counts[i]) + "  ";
+    lines << countLine.trimmed();
+    lines << "sprite cache: " + Percent(spriteHits, spriteMisses);
+    if(cacheHits || cacheMisses)
+        lines << "view cache: " + Percent(cacheHits, cacheMisses);
+
+    painter.save();
+    painter.resetTransform();
+    int lineHeight = painter.fontMetrics().height();
+    int width = 0;
+    for(const QString &line : lines)
+        width = max(width, painter.fontMetrics().horizontalAdvance(line));
+
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(0, 0, 0, 192));
+    painter.drawRect(QRectF(4., 4., width + 12., lineHeight * lines.size() + 8.));
+    painter.setPen(QColor(255, 255, 0));
+    for(int i = 0; i < lines.size(); ++i)
+        painter.drawText(QPointF(10., 8. + lineHeight * (i + 1) - painter.fontMetrics().descent()), lines[i]);
+    painter.restore();
+}
+
+
+
+// Get the paint time percentiles, in milliseconds, over the recent frames.
+double PaintProfiler::Percentile(double fraction) const
+{
+    if(times.empty())
+        return 0.;
+
+    vector<double> sorted = times;
+    auto it = sorted.begin() + min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+    nth_element(sorted.begin(), it, sorted.end());
+    return *it;
+}
@@ -0,0 +1,85 @@
+/* PaintProfiler.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef PAINTPROFILER_H
+#define PAINTPROFILER_H
+
+#include <QElapsedTimer>
+#include <QString>
+
+#include <vector>
+
+class QPainter;
+
+
+
+// Class for measuring how long a view takes to paint itself. A view calls
+// Begin() at the start of its paintEvent() and End() once it is done drawing,
+// reporting what it drew in between through Count() and Cache(). If profiling
+// is enabled, Draw() then shows the results in a small overlay, and each frame
+// is also written as a single line of "key=value" pairs to the log (if any), so
+// that automated offscreen runs can track regressions.
+class PaintProfiler {
+public:
+    // The primitives that are counted each frame.
+    enum Counter {
+        LINKS,
+        SYSTEMS,
+        SPRITES,
+        COUNTER_COUNT
+    };
+
+
+public:
+    explicit PaintProfiler(const QString &view);
+
+    // Turn profiling on or off for all views.
+    static void SetEnabled(bool isEnabled);
+    static bool IsEnabled();
+    // Write one line per painted frame to the given file. A path of "-" means
+    // standard error; an empty path turns the log off.
+    static void SetLogFile(const QString &path);
+
+    void Begin();
+    void Count(Counter counter, int count = 1);
+    // Record whether a view-level cache lookup hit or missed.
+    void Cache(bool hit);
+    void End();
+
+    // Draw the overlay in the top left corner of the painter's device.
+    void Draw(QPainter &painter) const;
+
+    // Get the paint time percentiles, in milliseconds, over the recent frames.
+    double Percentile(double fraction) const;
+
+
+private:
+    QString view;
+    QElapsedTimer timer;
+    bool isActive = false;
+
+    int frame = 0;
+    double lastTime = 0.;
+    // Ring buffer of the most recent frame times.
+    std::vector<double> times;
+    int next = 0;
+
+    int counts[COUNTER_COUNT] = {};
+    int cacheHits = 0;
+    int cacheMisses = 0;
+    int spriteHits = 0;
+    int spriteMisses = 0;
+};
+
+
+
+#endif // PAINTPROFILER_H
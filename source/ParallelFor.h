@@ -0,0 +1,74 @@
+/* ParallelFor.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef PARALLELFOR_H_
+#define PARALLELFOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+
+// Get the number of worker threads to use by default. This can be overridden
+// for the whole program (e.g. by a command line option); zero means one per core.
+inline int &ParallelThreads()
+{
+    static int threads = 0;
+    return threads;
+}
+
+
+
+inline int ParallelThreadCount(int count)
+{
+    int threads = ParallelThreads();
+    if(threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    return std::max(1, std::min(threads, count));
+}
+
+
+
+// Call function(i) for every i in [0, count), spread across worker threads.
+// Items are handed out one at a time, so uneven work balances itself. The
+// calling thread does its share of the work, and this returns once every item
+// is done. The function must not touch anything another item may be writing.
+template <class Function>
+void ParallelFor(int count, Function function)
+{
+    int threads = ParallelThreadCount(count);
+    if(threads <= 1)
+    {
+        for(int i = 0; i < count; ++i)
+            function(i);
+        return;
+    }
+
+    std::atomic<int> next(0);
+    auto work = [&next, count, &function]()
+    {
+        for(int i = next++; i < count; i = next++)
+            function(i);
+    };
+    std::vector<std::thread> workers;
+    for(int i = 1; i < threads; ++i)
+        workers.emplace_back(work);
+    work();
+    for(std::thread &worker : workers)
+        worker.join();
+}
+
+
+
+#endif
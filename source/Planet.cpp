@@ -31,6 +31,7 @@ void Planet::Load(const DataNode &node)
     if(node.Size() < 2)
         return;
     trueName = node.Token(1);
+    sourceLine = node.LineNumber();
 
     for(const DataNode &child : node)
     {
@@ -190,6 +191,28 @@ void Planet::Save(DataWriter &file) const
 
 
 
+// Get the hash of the data node this planet is saved as, like System::Hash().
+uint64_t Planet::Hash() const
+{
+    uint64_t hash = DataNode::EMPTY_HASH;
+    {
+        DataWriter file(&hash);
+        Save(file);
+    }
+    return hash;
+}
+
+
+
+// Get the line of the map file this planet was loaded from, or 0 if it
+// was not loaded from a file.
+int Planet::SourceLine() const
+{
+    return sourceLine;
+}
+
+
+
 // Get the name of the planet.
 const QString &Planet::TrueName() const
 {
@@ -15,6 +15,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <QString>
 
+#include <cstdint>
 #include <limits>
 #include <list>
 #include <optional>
@@ -36,6 +37,11 @@ public:
     void Load(const DataNode &node);
     void LoadTribute(const DataNode &node);
     void Save(DataWriter &file) const;
+    // Get the hash of the data node this planet is saved as, like System::Hash().
+    uint64_t Hash() const;
+    // Get the line of the map file this planet was loaded from, or 0 if it
+    // was not loaded from a file.
+    int SourceLine() const;
 
     // Get the name of the planet.
     const QString &TrueName() const;
@@ -97,6 +103,7 @@ public:
 
 private:
     QString trueName;
+    int sourceLine = 0;
     std::optional<QString> displayName;
     QString landscape;
     std::vector<std::pair<QString, DataNode>> description;
@@ -274,7 +274,7 @@ void PlanetView::TrueNameChanged()
 
         landscape->SetPlanet(&(mapData.Planets()[trueName->text()]));
 
-        mapData.SetChanged();
+        mapData.SetChanged(true, Map::OBJECTS | Map::PLANETS | Map::NAMES);
     }
 }
 
@@ -301,7 +301,7 @@ void PlanetView::DisplayNameChanged()
         planet.SetDisplayName(QString());
     else
         planet.SetDisplayName(displayName->text());
-    mapData.SetChanged();
+    mapData.SetChanged(true, Map::PLANETS);
 }
 
 
@@ -315,7 +315,7 @@ void PlanetView::AttributesChanged()
         if(planet.Attributes() != list)
         {
             planet.Attributes() = list;
-            mapData.SetChanged();
+            mapData.SetChanged(true, Map::PLANETS);
         }
     }
 }
@@ -335,7 +335,7 @@ void PlanetView::GovernmentChanged()
         planet.SetGovernment(QString());
     else
         planet.SetGovernment(text);
-    mapData.SetChanged();
+    mapData.SetChanged(true, Map::PLANETS);
 }
 
 
@@ -349,7 +349,7 @@ void PlanetView::DescriptionChanged()
         if(planet.Description() != newDescription)
         {
             planet.SetDescription(newDescription);
-            mapData.SetChanged();
+            mapData.SetChanged(true, Map::PLANETS);
         }
     }
 }
@@ -365,7 +365,7 @@ void PlanetView::SpaceportDescriptionChanged()
         if(planet.SpaceportDescription() != newDescription)
         {
             planet.SetSpaceportDescription(newDescription);
-            mapData.SetChanged();
+            mapData.SetChanged(true, Map::PLANETS);
         }
     }
 }
@@ -389,7 +389,7 @@ void PlanetView::ShipyardsChanged(QListWidgetItem *item)
     else if(item->text().isEmpty())
         planet.Shipyards().erase(std::next(planet.Shipyards().begin(), index));
 
-    mapData.SetChanged();
+    mapData.SetChanged(true, Map::PLANETS);
 
     UpdateShipyards();
 }
@@ -413,7 +413,7 @@ void PlanetView::OutfittersChanged(QListWidgetItem *item)
     else if(item->text().isEmpty())
         planet.Outfitters().erase(std::next(planet.Outfitters().begin(), index));
 
-    mapData.SetChanged();
+    mapData.SetChanged(true, Map::PLANETS);
 
     UpdateOutfitters();
 }
@@ -429,7 +429,7 @@ void PlanetView::ReputationChanged()
         if(planet.RequiredReputation() != value || std::isnan(planet.RequiredReputation()) != std::isnan(value))
         {
             planet.SetRequiredReputation(value);
-            mapData.SetChanged();
+            mapData.SetChanged(true, Map::PLANETS);
         }
     }
 }
@@ -445,7 +445,7 @@ void PlanetView::BribeChanged()
         if(planet.Bribe() != value || std::isnan(planet.Bribe()) != std::isnan(value))
         {
             planet.SetBribe(value);
-            mapData.SetChanged();
+            mapData.SetChanged(true, Map::PLANETS);
         }
     }
 }
@@ -461,7 +461,7 @@ void PlanetView::SecurityChanged()
         if(planet.Security() != value || std::isnan(planet.Security()) != std::isnan(value))
         {
             planet.SetSecurity(value);
-            mapData.SetChanged();
+            mapData.SetChanged(true, Map::PLANETS);
         }
     }
 }
@@ -477,7 +477,7 @@ void PlanetView::TributeChanged()
         if(planet.Tribute() != value || std::isnan(planet.Tribute()) != std::isnan(value))
         {
             planet.SetTribute(value);
-            mapData.SetChanged();
+            mapData.SetChanged(true, Map::PLANETS);
         }
     }
 }
@@ -493,7 +493,7 @@ void PlanetView::TributeThresholdChanged()
         if(planet.TributeThreshold() != value || std::isnan(planet.TributeThreshold()) != std::isnan(value))
         {
             planet.SetTributeThreshold(value);
-            mapData.SetChanged();
+            mapData.SetChanged(true, Map::PLANETS);
         }
     }
 }
@@ -520,7 +520,7 @@ void PlanetView::TributeFleetChanged(QTreeWidgetItem *item, int column)
     else
         return;
 
-    mapData.SetChanged();
+    mapData.SetChanged(true, Map::PLANETS);
 
     UpdateTributeFleets();
 }
@@ -541,7 +541,7 @@ void PlanetView::TributeFleetCountChanged(int value)
     tributeFleets->setCurrentItem(it->second);
 
     planet.TributeFleets()[it->second->text(2).toInt()].second = value;
-    mapData.SetChanged();
+    mapData.SetChanged(true, Map::PLANETS);
 }
 
 
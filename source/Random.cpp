@@ -0,0 +1,106 @@
+/* Random.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Random.h"
+
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+namespace {
+    const uint64_t MULTIPLIER = 6364136223846793005ull;
+    const uint64_t GOLDEN = 0x9E3779B97F4A7C15ull;
+
+    // The base seed, if one was given, and how many seeds have been handed out.
+    bool hasBaseSeed = false;
+    uint64_t baseSeed = 0;
+    atomic<uint64_t> seedCount;
+
+    // Scramble all the bits of a number, so that consecutive inputs give
+    // unrelated outputs (the "SplitMix64" finalizer).
+    uint64_t Mix(uint64_t value)
+    {
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+}
+
+
+
+Random::Random(uint64_t seed, uint64_t stream)
+    : seed(seed), increment((stream << 1) | 1)
+{
+    Bits();
+    state += seed;
+    Bits();
+}
+
+
+
+// Get a new seed for an operation. Normally this is different every time
+// the program runs, but if a base seed is given, the whole sequence of
+// seeds is the same each time.
+uint64_t Random::NewSeed()
+{
+    static const uint64_t start = hasBaseSeed ? baseSeed
+        : chrono::steady_clock::now().time_since_epoch().count();
+    uint64_t seed = Mix(start + ++seedCount * GOLDEN);
+    // Zero is used to mean "no seed."
+    return seed ? seed : GOLDEN;
+}
+
+
+
+void Random::SetBaseSeed(uint64_t seed)
+{
+    hasBaseSeed = true;
+    baseSeed = seed;
+}
+
+
+
+uint64_t Random::Seed() const
+{
+    return seed;
+}
+
+
+
+// Get 32 random bits.
+uint32_t Random::Bits()
+{
+    uint64_t old = state;
+    state = old * MULTIPLIER + increment;
+    uint32_t shifted = ((old >> 18) ^ old) >> 27;
+    uint32_t rotation = old >> 59;
+    return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+}
+
+
+
+// Get a random integer in [0, bound), or 0 if the bound is not positive.
+int Random::Int(int bound)
+{
+    if(bound <= 0)
+        return 0;
+    return (static_cast<uint64_t>(Bits()) * bound) >> 32;
+}
+
+
+
+// Get a random number in [0, 1).
+double Random::Real()
+{
+    return Bits() * (1. / 4294967296.);
+}
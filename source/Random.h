@@ -0,0 +1,55 @@
+/* Random.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <cstdint>
+
+
+
+// Class for a seeded random number generator (PCG32), used instead of rand()
+// for anything procedurally generated. Each operation (e.g. randomizing one
+// system) gets its own generator, so the same seed always gives the same
+// result, generators on different threads do not share any state, and the
+// seed can be recorded along with the edit. Generators with the same seed but
+// different streams give unrelated sequences, so a batch operation can give
+// each of its parts its own stream.
+class Random {
+public:
+    explicit Random(uint64_t seed, uint64_t stream = 0);
+
+    // Get a new seed for an operation. Normally this is different every time
+    // the program runs, but if a base seed is given, the whole sequence of
+    // seeds is the same each time.
+    static uint64_t NewSeed();
+    static void SetBaseSeed(uint64_t seed);
+
+    uint64_t Seed() const;
+
+    // Get 32 random bits.
+    uint32_t Bits();
+    // Get a random integer in [0, bound), or 0 if the bound is not positive.
+    int Int(int bound);
+    // Get a random number in [0, 1).
+    double Real();
+
+
+private:
+    uint64_t seed;
+    uint64_t state = 0;
+    uint64_t increment;
+};
+
+
+
+#endif
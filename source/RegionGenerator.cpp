@@ -0,0 +1,135 @@
+/* RegionGenerator.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "RegionGenerator.h"
+
+#include "Map.h"
+#include "ParallelFor.h"
+#include "Random.h"
+#include "SpatialGrid.h"
+#include "System.h"
+
+#include <QVector2D>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+    // Random placement can fit about 0.7 / spacing^2 systems per unit of area
+    // before it runs out of room. By default, the spacing is chosen so that the
+    // requested systems take up about 70% of that room.
+    const double SPACING_SCALE = .7;
+    const double MIN_SPACING = 20.;
+    const double LINK_SCALE = 1.75;
+    // Give up once this many random positions per system have been tried.
+    const int ATTEMPTS = 30;
+
+    double Area(const QPolygonF &polygon)
+    {
+        double area = 0.;
+        for(int i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+            area += polygon[j].x() * polygon[i].y() - polygon[i].x() * polygon[j].y();
+        return fabs(.5 * area);
+    }
+}
+
+
+
+RegionGenerator::RegionGenerator(const QPolygonF &region, uint64_t seed)
+    : region(region), seed(seed)
+{
+}
+
+
+
+// The least distance between systems. By default, this is chosen so that
+// the requested number of systems fits in the region.
+void RegionGenerator::SetSpacing(double spacing)
+{
+    this->spacing = spacing;
+}
+
+
+
+// New systems are linked to every system within this distance. By default,
+// this is a little under twice the spacing.
+void RegionGenerator::SetLinkDistance(double distance)
+{
+    linkDistance = distance;
+}
+
+
+
+// Generate up to the given number of systems, fewer if the region is full.
+// They are named the given prefix followed by a number, skipping any names
+// that the map already has. The map itself is not changed.
+vector<System> RegionGenerator::Generate(const Map &map, int count, const QString &prefix) const
+{
+    vector<System> systems;
+    double area = Area(region);
+    if(count <= 0 || area <= 0.)
+        return systems;
+
+    double minDistance = (spacing > 0. ? spacing : max(MIN_SPACING, SPACING_SCALE * sqrt(area / count)));
+    double maxLink = (linkDistance > 0. ? linkDistance : LINK_SCALE * minDistance);
+
+    // The grid holds the new systems, by their index, and the existing ones,
+    // by -1 minus their index, so that the new ones keep clear of both.
+    SpatialGrid grid(max(minDistance, maxLink));
+    vector<const QString *> existing;
+    for(const auto &it : map.Systems())
+    {
+        grid.Add(it.second.Position().toPointF(), -1 - static_cast<int>(existing.size()));
+        existing.push_back(&it.first);
+    }
+
+    // Throw random darts at the region, keeping each one that is not too close
+    // to any other system. The first stream of the seed is used for this.
+    Random placement(seed);
+    QRectF bounds = region.boundingRect();
+    vector<QPointF> points;
+    for(int attempt = 0; static_cast<int>(points.size()) < count && attempt < ATTEMPTS * count; ++attempt)
+    {
+        double x = bounds.left() + placement.Real() * bounds.width();
+        double y = bounds.top() + placement.Real() * bounds.height();
+        QPointF point(x, y);
+        if(!region.containsPoint(point, Qt::OddEvenFill) || !grid.Query(point, minDistance).empty())
+            continue;
+        grid.Add(point, points.size());
+        points.push_back(point);
+    }
+
+    vector<QString> names;
+    for(int number = 1; names.size() < points.size(); ++number)
+    {
+        QString name = prefix + " " + QString::number(number);
+        if(!map.Systems().count(name))
+            names.push_back(name);
+    }
+
+    // Each system only writes to itself, and gets the next stream of the seed.
+    systems.resize(points.size());
+    ParallelFor(points.size(), [&](int i)
+    {
+        System &system = systems[i];
+        Random random(seed, i + 1);
+        system.Init(names[i], QVector2D(points[i]), random);
+        for(const Map::Commodity &commodity : map.Commodities())
+            system.SetTrade(commodity.name, (commodity.low + commodity.high) / 2);
+        for(int j : grid.Query(points[i], maxLink))
+            if(j != i)
+                system.AddLink(j >= 0 ? names[j] : *existing[-1 - j]);
+    });
+    return systems;
+}
@@ -0,0 +1,59 @@
+/* RegionGenerator.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef REGIONGENERATOR_H_
+#define REGIONGENERATOR_H_
+
+#include <QPolygonF>
+#include <QString>
+
+#include <cstdint>
+#include <vector>
+
+class Map;
+class System;
+
+
+
+// Class for filling a whole region of the map with new systems at once. The
+// positions are scattered by Poisson-disk sampling, so no two systems (new or
+// existing) are closer than the spacing. Then each system's stellar objects
+// are generated on a worker thread, using its own stream of the one seed, and
+// every new system is linked to all the systems within the link distance. The
+// result is the same for the same seed, however many threads there are.
+class RegionGenerator {
+public:
+    RegionGenerator(const QPolygonF &region, uint64_t seed);
+
+    // The least distance between systems. By default, this is chosen so that
+    // the requested number of systems fits in the region.
+    void SetSpacing(double spacing);
+    // New systems are linked to every system within this distance. By default,
+    // this is a little under twice the spacing.
+    void SetLinkDistance(double distance);
+
+    // Generate up to the given number of systems, fewer if the region is full.
+    // They are named the given prefix followed by a number, skipping any names
+    // that the map already has. The map itself is not changed.
+    std::vector<System> Generate(const Map &map, int count, const QString &prefix) const;
+
+
+private:
+    QPolygonF region;
+    uint64_t seed;
+    double spacing = 0.;
+    double linkDistance = 0.;
+};
+
+
+
+#endif
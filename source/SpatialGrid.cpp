@@ -0,0 +1,110 @@
+/* SpatialGrid.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "SpatialGrid.h"
+
+#include <cmath>
+
+using namespace std;
+
+
+
+SpatialGrid::SpatialGrid(double cellSize)
+    : cellSize(cellSize)
+{
+}
+
+
+
+void SpatialGrid::Clear()
+{
+    cells.clear();
+}
+
+
+
+void SpatialGrid::Add(const QPointF &point, int index)
+{
+    cells[Key(Cell(point.x()), Cell(point.y()))].push_back({point, index});
+}
+
+
+
+bool SpatialGrid::IsEmpty() const
+{
+    return cells.empty();
+}
+
+
+
+// Get the indices of all the points inside the given rectangle.
+vector<int> SpatialGrid::Query(const QRectF &rect) const
+{
+    vector<int> result;
+    QRectF bounds = rect.normalized();
+    int left = Cell(bounds.left());
+    int right = Cell(bounds.right());
+    int top = Cell(bounds.top());
+    int bottom = Cell(bounds.bottom());
+    for(int y = top; y <= bottom; ++y)
+        for(int x = left; x <= right; ++x)
+        {
+            auto it = cells.find(Key(x, y));
+            if(it == cells.end())
+                continue;
+            for(const Entry &entry : it->second)
+                if(entry.point.x() >= bounds.left() && entry.point.x() <= bounds.right()
+                        && entry.point.y() >= bounds.top() && entry.point.y() <= bounds.bottom())
+                    result.push_back(entry.index);
+        }
+    return result;
+}
+
+
+
+// Get the indices of all the points within the given distance of a point.
+vector<int> SpatialGrid::Query(const QPointF &center, double radius) const
+{
+    vector<int> result;
+    int left = Cell(center.x() - radius);
+    int right = Cell(center.x() + radius);
+    int top = Cell(center.y() - radius);
+    int bottom = Cell(center.y() + radius);
+    for(int y = top; y <= bottom; ++y)
+        for(int x = left; x <= right; ++x)
+        {
+            auto it = cells.find(Key(x, y));
+            if(it == cells.end())
+                continue;
+            for(const Entry &entry : it->second)
+            {
+                QPointF d = entry.point - center;
+                if(d.x() * d.x() + d.y() * d.y() <= radius * radius)
+                    result.push_back(entry.index);
+            }
+        }
+    return result;
+}
+
+
+
+int64_t SpatialGrid::Key(int x, int y) const
+{
+    return (static_cast<int64_t>(x) << 32) | static_cast<uint32_t>(y);
+}
+
+
+
+int SpatialGrid::Cell(double coordinate) const
+{
+    return floor(coordinate / cellSize);
+}
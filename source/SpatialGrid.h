@@ -0,0 +1,60 @@
+/* SpatialGrid.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef SPATIALGRID_H_
+#define SPATIALGRID_H_
+
+#include <QPointF>
+#include <QRectF>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+
+// Class for quickly finding which of a set of points lie within a region. The
+// points are sorted into square buckets of a fixed size, so a query only has
+// to look at the buckets that overlap the region. Each point is identified by
+// an index chosen by the caller (e.g. its position in some other vector).
+class SpatialGrid {
+public:
+    explicit SpatialGrid(double cellSize = 100.);
+
+    void Clear();
+    void Add(const QPointF &point, int index);
+    bool IsEmpty() const;
+
+    // Get the indices of all the points inside the given rectangle.
+    std::vector<int> Query(const QRectF &rect) const;
+    // Get the indices of all the points within the given distance of a point.
+    std::vector<int> Query(const QPointF &center, double radius) const;
+
+
+private:
+    int64_t Key(int x, int y) const;
+    int Cell(double coordinate) const;
+
+
+private:
+    struct Entry {
+        QPointF point;
+        int index;
+    };
+
+    double cellSize;
+    std::unordered_map<int64_t, std::vector<Entry>> cells;
+};
+
+
+
+#endif
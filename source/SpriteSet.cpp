@@ -13,30 +13,56 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "SpriteSet.h"
 
 #include <QFileInfo>
+#include <QImage>
 #include <QString>
 
 #include <map>
+#include <mutex>
 
 using namespace std;
 
 namespace {
     QString root;
+    mutex rootMutex;
     map<QString, QPixmap> sprite;
+
+    int cacheHits = 0;
+    int cacheMisses = 0;
+
+    // Get the path to the given sprite's image file, or an empty string if it
+    // does not exist.
+    QString FindFile(const QString &name)
+    {
+        QString baseName = SpriteSet::RootPath() + name;
+        QFileInfo jpg(baseName + ".jpg");
+        if(jpg.exists())
+            return jpg.filePath();
+        QFileInfo png(baseName + ".png");
+        if(png.exists())
+            return png.filePath();
+        return QString();
+    }
 }
 
 
 
+// The root path may be set and read from any thread, e.g. by maps being
+// loaded in parallel. Everything else must be done on the main thread.
 void SpriteSet::SetRootPath(const QString &path)
 {
-    root = path;
-    if(!root.isEmpty() && !root.endsWith('/'))
-        root += '/';
+    QString newRoot = path;
+    if(!newRoot.isEmpty() && !newRoot.endsWith('/'))
+        newRoot += '/';
+
+    lock_guard<mutex> lock(rootMutex);
+    root = newRoot;
 }
 
 
 
-const QString &SpriteSet::RootPath()
+QString SpriteSet::RootPath()
 {
+    lock_guard<mutex> lock(rootMutex);
     return root;
 }
 
@@ -46,26 +72,32 @@ QPixmap SpriteSet::Get(const QString &name)
 {
     auto it = sprite.find(name);
     if(it != sprite.end())
+    {
+        ++cacheHits;
         return it->second;
+    }
+    ++cacheMisses;
 
     QPixmap image;
-
-    QString baseName = root + name;
-    QFileInfo jpg(baseName + ".jpg");
-    if(jpg.exists())
-        image.load(jpg.filePath());
-    else
-    {
-        QFileInfo png(baseName + ".png");
-        if(png.exists())
-            image.load(png.filePath());
-    }
+    QString path = FindFile(name);
+    if(!path.isEmpty())
+        image.load(path);
     sprite[name] = image;
     return image;
 }
 
 
 
+// Load an image without adding it to the set, e.g. to copy it into a
+// larger one. Returns a null image if there is no such sprite.
+QImage SpriteSet::Load(const QString &name)
+{
+    QString path = FindFile(name);
+    return path.isEmpty() ? QImage() : QImage(path);
+}
+
+
+
 // Set an entry in the set (using an image loaded elsewhere).
 void SpriteSet::Set(const QString &name, QImage image)
 {
@@ -74,3 +106,17 @@ void SpriteSet::Set(const QString &name, QImage image)
 
     sprite[name] = QPixmap::fromImage(image);
 }
+
+
+
+int SpriteSet::CacheHits()
+{
+    return cacheHits;
+}
+
+
+
+int SpriteSet::CacheMisses()
+{
+    return cacheMisses;
+}
@@ -20,13 +20,23 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 class SpriteSet {
 public:
+    // The root path may be set and read from any thread, e.g. by maps being
+    // loaded in parallel. Everything else must be done on the main thread.
     static void SetRootPath(const QString &path);
-    static const QString &RootPath();
+    static QString RootPath();
 
     static QPixmap Get(const QString &name);
+    // Load an image without adding it to the set, e.g. to copy it into a
+    // larger one. Returns a null image if there is no such sprite.
+    static QImage Load(const QString &name);
 
     // Set an entry in the set (using an image loaded elsewhere).
     static void Set(const QString &name, QImage image);
+
+    // Get the number of calls to Get() that did or did not find the sprite
+    // already loaded, for profiling.
+    static int CacheHits();
+    static int CacheMisses();
 };
 
 
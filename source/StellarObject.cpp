@@ -13,12 +13,14 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "StellarObject.h"
 
 #include "Planet.h"
+#include "Random.h"
 
 #include <QString>
 
 #include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <cstdint>
-#include <map>
 #include <string>
 
 using namespace std;
@@ -27,174 +29,430 @@ namespace {
     static const int MOON_RADIUS = 50;
     static const int GIANT_RADIUS = 120;
 
-    struct Info { int radius; int info; };
-    const map<QString, Info> INFO = {
-        {"planet/callisto", {47, 0}},
-        {"planet/cloud0", {76, 0}},
-        {"planet/cloud1", {100, 0}},
-        {"planet/cloud2", {101, 0}},
-        {"planet/cloud3", {82, 0}},
-        {"planet/cloud4", {91, 0}},
-        {"planet/cloud5", {116, 0}},
-        {"planet/cloud6", {86, 0}},
-        {"planet/cloud7", {70, 0}},
-        {"planet/cloud8", {77, 0}},
-        {"planet/desert0", {75, 0}},
-        {"planet/desert1", {96, 0}},
-        {"planet/desert2", {81, 0}},
-        {"planet/desert3", {85, 0}},
-        {"planet/desert4", {33, 0}},
-        {"planet/desert5", {82, 0}},
-        {"planet/desert6", {85, 0}},
-        {"planet/desert7", {64, 0}},
-        {"planet/desert8", {74, 0}},
-        {"planet/desert9", {66, 0}},
-        {"planet/desert10", {86, 0}},
-        {"planet/dust0", {28, 0}},
-        {"planet/dust1", {42, 0}},
-        {"planet/dust2", {51, 0}},
-        {"planet/dust3", {37, 0}},
-        {"planet/dust4", {42, 0}},
-        {"planet/dust5", {47, 0}},
-        {"planet/dust6", {57, 0}},
-        {"planet/dust7", {37, 0}},
-        {"planet/earth", {86, 2}},
-        {"planet/europa", {31, 0}},
-        {"planet/fog0", {107, 0}},
-        {"planet/forest0", {97, 2}},
-        {"planet/forest1", {81, 2}},
-        {"planet/forest2", {90, 2}},
-        {"planet/forest3", {71, 2}},
-        {"planet/forest4", {94, 2}},
-        {"planet/forest5", {83, 2}},
-        {"planet/forest6", {69, 2}},
-        {"planet/ganymede", {52, 0}},
-        {"planet/gas0", {198, 0}},
-        {"planet/gas1", {161, 0}},
-        {"planet/gas2", {122, 0}},
-        {"planet/gas3", {217, 0}},
-        {"planet/gas4", {175, 0}},
-        {"planet/gas5", {182, 0}},
-        {"planet/gas6", {217, 0}},
-        {"planet/gas7", {174, 0}},
-        {"planet/gas8", {133, 0}},
-        {"planet/gas9", {168, 0}},
-        {"planet/gas10", {134, 0}},
-        {"planet/gas11", {183, 0}},
-        {"planet/gas12", {213, 0}},
-        {"planet/gas13", {203, 0}},
-        {"planet/gas14", {159, 0}},
-        {"planet/gas15", {134, 0}},
-        {"planet/gas16", {134, 0}},
-        {"planet/gas17", {154, 0}},
-        {"planet/ice0", {37, 0}},
-        {"planet/ice1", {97, 0}},
-        {"planet/ice2", {75, 0}},
-        {"planet/ice3", {90, 0}},
-        {"planet/ice4", {75, 0}},
-        {"planet/ice5", {88, 0}},
-        {"planet/ice6", {75, 0}},
-        {"planet/ice7", {47, 0}},
-        {"planet/ice8", {37, 0}},
-        {"planet/io", {36, 0}},
-        {"planet/jupiter", {189, 0}},
-        {"planet/lava0", {48, 0}},
-        {"planet/lava1", {53, 0}},
-        {"planet/lava2", {50, 0}},
-        {"planet/lava3", {64, 0}},
-        {"planet/lava4", {74, 0}},
-        {"planet/lava5", {66, 0}},
-        {"planet/lava6", {56, 0}},
-        {"planet/lava7", {60, 0}},
-        {"planet/luna", {38, 0}},
-        {"planet/mars", {72, 0}},
-        {"planet/mercury", {53, 0}},
-        {"planet/miranda", {33, 0}},
-        {"planet/neptune", {139, 0}},
-        {"planet/oberon", {28, 0}},
-        {"planet/ocean0", {77, 1}},
-        {"planet/ocean1", {87, 1}},
-        {"planet/ocean2", {96, 1}},
-        {"planet/ocean3", {81, 1}},
-        {"planet/ocean4", {93, 1}},
-        {"planet/ocean5", {77, 1}},
-        {"planet/ocean6", {101, 1}},
-        {"planet/ocean7", {82, 1}},
-        {"planet/ocean8", {95, 1}},
-        {"planet/ocean9", {86, 1}},
-        {"planet/rhea", {43, 0}},
-        {"planet/rock0", {37, 0}},
-        {"planet/rock1", {79, 0}},
-        {"planet/rock2", {83, 0}},
-        {"planet/rock3", {37, 0}},
-        {"planet/rock4", {93, 0}},
-        {"planet/rock5", {60, 0}},
-        {"planet/rock6", {75, 0}},
-        {"planet/rock7", {32, 0}},
-        {"planet/rock8", {65, 0}},
-        {"planet/rock9", {74, 0}},
-        {"planet/rock10", {98, 0}},
-        {"planet/rock11", {55, 0}},
-        {"planet/rock12", {85, 0}},
-        {"planet/rock13", {75, 0}},
-        {"planet/rock14", {46, 0}},
-        {"planet/rock15", {56, 0}},
-        {"planet/rock16", {71, 0}},
-        {"planet/rock17", {28, 0}},
-        {"planet/rock18", {75, 0}},
-        {"planet/rock19", {72, 0}},
-        {"planet/tethys", {28, 0}},
-        {"planet/titan", {54, 0}},
-        {"planet/uranus", {154, 0}},
-        {"planet/venus", {80, 0}},
-        {"planet/water0", {56, 1}},
-        {"planet/water1", {96, 1}},
-
-
-        {"planet/station0", {30, 3}},
-        {"planet/station1", {30, 3}},
-        {"planet/station1k", {35, 3}},
-        {"planet/station1kd", {35, 3}},
-        {"planet/station2", {35, 3}},
-        {"planet/station2k", {45, 3}},
-        {"planet/station2kd", {45, 3}},
-        {"planet/station3", {35, 3}},
-        {"planet/station3k", {55, 3}},
-        {"planet/station3kd", {55, 3}},
-        {"planet/station4", {45, 3}},
-        {"planet/station5", {55, 3}},
-        {"planet/station6", {65, 3}},
-        {"planet/station7", {45, 3}},
-
-        {"planet/wisp", {85, 3}},
-        {"planet/wormhole", {195, 3}},
-        {"planet/wormhole-red", {195, 3}},
-
-        {"planet/ringworld", {20, 3}},
-        {"planet/ringworld left", {20, 3}},
-        {"planet/ringworld right", {20, 3}},
-
-        {"star/b5", {60, 1}},
-        {"star/a0", {50, 1}},
-        {"star/a5", {45, 2}},
-        {"star/f0", {39, 3}},
-        {"star/f5", {35, 8}},
-        {"star/f5-old", {35, 0}},
-        {"star/g0", {30, 12}},
-        {"star/g0-old", {30, 0}},
-        {"star/g5", {25, 14}},
-        {"star/g5-old", {25, 0}},
-        {"star/k0", {23, 17}},
-        {"star/k0-old", {23, 0}},
-        {"star/k5", {22, 16}},
-        {"star/k5-old", {22, 0}},
-        {"star/m0", {20, 12}},
-        {"star/m4", {18, 9}},
-        {"star/m8", {15, 5}},
-        {"star/giant", {50, 0}},
-        {"star/nova", {12, 0}},
-        {"star/wr", {25, 0}}
+    // The radius of each known sprite, and what sort of object it is: 0 for an
+    // uninhabited planet, 1 for a planet that may be habitable, 2 for one that
+    // is definitely inhabited, and 3 for a station or other special object.
+    // For stars, this is instead how likely that star is to be picked, out of
+    // 100. The names must be kept in sorted order.
+    struct Info { const char *name; int radius; int info; };
+    constexpr Info INFO[] = {
+        {"planet/callisto", 47, 0},
+        {"planet/cloud0", 76, 0},
+        {"planet/cloud1", 100, 0},
+        {"planet/cloud2", 101, 0},
+        {"planet/cloud3", 82, 0},
+        {"planet/cloud4", 91, 0},
+        {"planet/cloud5", 116, 0},
+        {"planet/cloud6", 86, 0},
+        {"planet/cloud7", 70, 0},
+        {"planet/cloud8", 77, 0},
+        {"planet/desert0", 75, 0},
+        {"planet/desert1", 96, 0},
+        {"planet/desert10", 86, 0},
+        {"planet/desert2", 81, 0},
+        {"planet/desert3", 85, 0},
+        {"planet/desert4", 33, 0},
+        {"planet/desert5", 82, 0},
+        {"planet/desert6", 85, 0},
+        {"planet/desert7", 64, 0},
+        {"planet/desert8", 74, 0},
+        {"planet/desert9", 66, 0},
+        {"planet/dust0", 28, 0},
+        {"planet/dust1", 42, 0},
+        {"planet/dust2", 51, 0},
+        {"planet/dust3", 37, 0},
+        {"planet/dust4", 42, 0},
+        {"planet/dust5", 47, 0},
+        {"planet/dust6", 57, 0},
+        {"planet/dust7", 37, 0},
+        {"planet/earth", 86, 2},
+        {"planet/europa", 31, 0},
+        {"planet/fog0", 107, 0},
+        {"planet/forest0", 97, 2},
+        {"planet/forest1", 81, 2},
+        {"planet/forest2", 90, 2},
+        {"planet/forest3", 71, 2},
+        {"planet/forest4", 94, 2},
+        {"planet/forest5", 83, 2},
+        {"planet/forest6", 69, 2},
+        {"planet/ganymede", 52, 0},
+        {"planet/gas0", 198, 0},
+        {"planet/gas1", 161, 0},
+        {"planet/gas10", 134, 0},
+        {"planet/gas11", 183, 0},
+        {"planet/gas12", 213, 0},
+        {"planet/gas13", 203, 0},
+        {"planet/gas14", 159, 0},
+        {"planet/gas15", 134, 0},
+        {"planet/gas16", 134, 0},
+        {"planet/gas17", 154, 0},
+        {"planet/gas2", 122, 0},
+        {"planet/gas3", 217, 0},
+        {"planet/gas4", 175, 0},
+        {"planet/gas5", 182, 0},
+        {"planet/gas6", 217, 0},
+        {"planet/gas7", 174, 0},
+        {"planet/gas8", 133, 0},
+        {"planet/gas9", 168, 0},
+        {"planet/ice0", 37, 0},
+        {"planet/ice1", 97, 0},
+        {"planet/ice2", 75, 0},
+        {"planet/ice3", 90, 0},
+        {"planet/ice4", 75, 0},
+        {"planet/ice5", 88, 0},
+        {"planet/ice6", 75, 0},
+        {"planet/ice7", 47, 0},
+        {"planet/ice8", 37, 0},
+        {"planet/io", 36, 0},
+        {"planet/jupiter", 189, 0},
+        {"planet/lava0", 48, 0},
+        {"planet/lava1", 53, 0},
+        {"planet/lava2", 50, 0},
+        {"planet/lava3", 64, 0},
+        {"planet/lava4", 74, 0},
+        {"planet/lava5", 66, 0},
+        {"planet/lava6", 56, 0},
+        {"planet/lava7", 60, 0},
+        {"planet/luna", 38, 0},
+        {"planet/mars", 72, 0},
+        {"planet/mercury", 53, 0},
+        {"planet/miranda", 33, 0},
+        {"planet/neptune", 139, 0},
+        {"planet/oberon", 28, 0},
+        {"planet/ocean0", 77, 1},
+        {"planet/ocean1", 87, 1},
+        {"planet/ocean2", 96, 1},
+        {"planet/ocean3", 81, 1},
+        {"planet/ocean4", 93, 1},
+        {"planet/ocean5", 77, 1},
+        {"planet/ocean6", 101, 1},
+        {"planet/ocean7", 82, 1},
+        {"planet/ocean8", 95, 1},
+        {"planet/ocean9", 86, 1},
+        {"planet/rhea", 43, 0},
+        {"planet/ringworld", 20, 3},
+        {"planet/ringworld left", 20, 3},
+        {"planet/ringworld right", 20, 3},
+        {"planet/rock0", 37, 0},
+        {"planet/rock1", 79, 0},
+        {"planet/rock10", 98, 0},
+        {"planet/rock11", 55, 0},
+        {"planet/rock12", 85, 0},
+        {"planet/rock13", 75, 0},
+        {"planet/rock14", 46, 0},
+        {"planet/rock15", 56, 0},
+        {"planet/rock16", 71, 0},
+        {"planet/rock17", 28, 0},
+        {"planet/rock18", 75, 0},
+        {"planet/rock19", 72, 0},
+        {"planet/rock2", 83, 0},
+        {"planet/rock3", 37, 0},
+        {"planet/rock4", 93, 0},
+        {"planet/rock5", 60, 0},
+        {"planet/rock6", 75, 0},
+        {"planet/rock7", 32, 0},
+        {"planet/rock8", 65, 0},
+        {"planet/rock9", 74, 0},
+        {"planet/station0", 30, 3},
+        {"planet/station1", 30, 3},
+        {"planet/station1k", 35, 3},
+        {"planet/station1kd", 35, 3},
+        {"planet/station2", 35, 3},
+        {"planet/station2k", 45, 3},
+        {"planet/station2kd", 45, 3},
+        {"planet/station3", 35, 3},
+        {"planet/station3k", 55, 3},
+        {"planet/station3kd", 55, 3},
+        {"planet/station4", 45, 3},
+        {"planet/station5", 55, 3},
+        {"planet/station6", 65, 3},
+        {"planet/station7", 45, 3},
+        {"planet/tethys", 28, 0},
+        {"planet/titan", 54, 0},
+        {"planet/uranus", 154, 0},
+        {"planet/venus", 80, 0},
+        {"planet/water0", 56, 1},
+        {"planet/water1", 96, 1},
+        {"planet/wisp", 85, 3},
+        {"planet/wormhole", 195, 3},
+        {"planet/wormhole-red", 195, 3},
+        {"star/a0", 50, 1},
+        {"star/a5", 45, 2},
+        {"star/b5", 60, 1},
+        {"star/f0", 39, 3},
+        {"star/f5", 35, 8},
+        {"star/f5-old", 35, 0},
+        {"star/g0", 30, 12},
+        {"star/g0-old", 30, 0},
+        {"star/g5", 25, 14},
+        {"star/g5-old", 25, 0},
+        {"star/giant", 50, 0},
+        {"star/k0", 23, 17},
+        {"star/k0-old", 23, 0},
+        {"star/k5", 22, 16},
+        {"star/k5-old", 22, 0},
+        {"star/m0", 20, 12},
+        {"star/m4", 18, 9},
+        {"star/m8", 15, 5},
+        {"star/nova", 12, 0},
+        {"star/wr", 25, 0},
     };
+    constexpr int INFO_COUNT = sizeof(INFO) / sizeof(INFO[0]);
+
+    constexpr bool IsSorted()
+    {
+        for(int i = 1; i < INFO_COUNT; ++i)
+        {
+            const char *a = INFO[i - 1].name;
+            const char *b = INFO[i].name;
+            while(*a && *a == *b)
+            {
+                ++a;
+                ++b;
+            }
+            if(static_cast<unsigned char>(*a) >= static_cast<unsigned char>(*b))
+                return false;
+        }
+        return true;
+    }
+    static_assert(IsSorted(), "The sprite table must be in sorted order, with no duplicates.");
+
+    // The sprite names are found in the table with a perfect hash, built when
+    // compiling: each name's hash picks one of the buckets, and each bucket has
+    // its own seed for mixing the hash into a slot in the table. The seeds are
+    // chosen so that no two names ever land in the same slot.
+    const int BUCKETS = 64;
+    const int SLOTS = 256;
+    const uint32_t FNV_BASIS = 2166136261u;
+    const uint32_t FNV_PRIME = 16777619u;
+
+    constexpr uint32_t Hash(const char *name)
+    {
+        uint32_t hash = FNV_BASIS;
+        for( ; *name; ++name)
+            hash = (hash ^ static_cast<unsigned char>(*name)) * FNV_PRIME;
+        return hash;
+    }
+
+    // This must give the same result as the above for any name in the table.
+    uint32_t Hash(const QString &name)
+    {
+        uint32_t hash = FNV_BASIS;
+        for(const QChar &c : name)
+            hash = (hash ^ c.unicode()) * FNV_PRIME;
+        return hash;
+    }
+
+    constexpr uint32_t Mix(uint32_t hash, uint32_t seed)
+    {
+        hash ^= seed * 0x9E3779B9u;
+        hash ^= hash >> 16;
+        hash *= 0x85EBCA6Bu;
+        hash ^= hash >> 13;
+        hash *= 0xC2B2AE35u;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    struct PerfectHash {
+        uint32_t seed[BUCKETS];
+        // The index in INFO of the name in each slot, or -1 if it is empty.
+        int16_t slot[SLOTS];
+    };
+
+    // Place the biggest buckets first, while the table is emptiest, trying
+    // seeds for each bucket until all of its names land in empty slots.
+    constexpr PerfectHash MakeHash()
+    {
+        PerfectHash result{};
+        for(int16_t &slot : result.slot)
+            slot = -1;
+
+        uint32_t hash[INFO_COUNT] = {};
+        int size[BUCKETS] = {};
+        int largest = 0;
+        for(int i = 0; i < INFO_COUNT; ++i)
+        {
+            hash[i] = Hash(INFO[i].name);
+            int &bucketSize = size[hash[i] % BUCKETS];
+            largest = max(largest, ++bucketSize);
+        }
+
+        for(int bucketSize = largest; bucketSize > 0; --bucketSize)
+            for(int bucket = 0; bucket < BUCKETS; ++bucket)
+            {
+                if(size[bucket] != bucketSize)
+                    continue;
+
+                for(uint32_t seed = 1; ; ++seed)
+                {
+                    bool taken[SLOTS] = {};
+                    bool fits = true;
+                    for(int i = 0; fits && i < INFO_COUNT; ++i)
+                        if(static_cast<int>(hash[i] % BUCKETS) == bucket)
+                        {
+                            uint32_t slot = Mix(hash[i], seed) % SLOTS;
+                            fits = (result.slot[slot] < 0 && !taken[slot]);
+                            taken[slot] = true;
+                        }
+                    if(!fits)
+                        continue;
+
+                    result.seed[bucket] = seed;
+                    for(int i = 0; i < INFO_COUNT; ++i)
+                        if(static_cast<int>(hash[i] % BUCKETS) == bucket)
+                            result.slot[Mix(hash[i], seed) % SLOTS] = i;
+                    break;
+                }
+            }
+        return result;
+    }
+    constexpr PerfectHash SPRITE_HASH = MakeHash();
+
+    // Get the index in INFO of the given sprite, or -1 if it is not there.
+    int FindSprite(const QString &sprite)
+    {
+        uint32_t hash = Hash(sprite);
+        int index = SPRITE_HASH.slot[Mix(hash, SPRITE_HASH.seed[hash % BUCKETS]) % SLOTS];
+        return (index >= 0 && sprite == INFO[index].name) ? index : -1;
+    }
+
+    static_assert(INFO_COUNT <= StellarObject::UsedSprites().size(), "Every sprite must have a bit in UsedSprites.");
+
+    // One category of sprites to pick from at random, e.g. the moons, each with
+    // a weight. Each pick takes constant time, using Walker's alias method: the
+    // weights are cut up and rearranged into equal columns, one per sprite,
+    // each of which holds part of that sprite's weight and may be topped up
+    // with part of one other ("alias") sprite's weight. A pick is then one
+    // random column and one random height within it.
+    class Category {
+    public:
+        // Make a category of the sprites for which the given function returns
+        // a weight greater than zero.
+        template <class Weight>
+        explicit Category(Weight weight);
+
+        // Pick a random sprite, avoiding those that are already used unless
+        // every sprite in this category is. Returns the index in INFO, or -1
+        // if the category is empty.
+        int Pick(Random &random, const StellarObject::UsedSprites &used) const;
+
+    private:
+        vector<int> sprites;
+        vector<double> weights;
+        // The height at which each column switches from its own sprite to its
+        // alias, as a fraction of the column.
+        vector<double> threshold;
+        vector<int> alias;
+    };
+
+
+
+    template <class Weight>
+    Category::Category(Weight weight)
+    {
+        double total = 0.;
+        for(int i = 0; i < INFO_COUNT; ++i)
+        {
+            double value = weight(INFO[i]);
+            if(value > 0.)
+            {
+                sprites.push_back(i);
+                weights.push_back(value);
+                total += value;
+            }
+        }
+        // Every category is built from the fixed sprite table, so an empty one
+        // means the table or the weight function is wrong.
+        assert(!sprites.empty() && "A sprite category must not be empty.");
+        if(sprites.empty())
+            return;
+
+        // Scale the weights so that a full column is 1, then fill each column
+        // that is too short from one that is too tall.
+        int count = sprites.size();
+        threshold.resize(count, 1.);
+        alias.resize(count);
+        vector<int> small;
+        vector<int> large;
+        for(int i = 0; i < count; ++i)
+        {
+            threshold[i] = weights[i] * count / total;
+            alias[i] = i;
+            (threshold[i] < 1. ? small : large).push_back(i);
+        }
+        while(!small.empty() && !large.empty())
+        {
+            int shorter = small.back();
+            small.pop_back();
+            int taller = large.back();
+            alias[shorter] = taller;
+            threshold[taller] -= 1. - threshold[shorter];
+            if(threshold[taller] < 1.)
+            {
+                large.pop_back();
+                small.push_back(taller);
+            }
+        }
+        // Anything left over is only short or tall by rounding error.
+        for(int i : small)
+            threshold[i] = 1.;
+        for(int i : large)
+            threshold[i] = 1.;
+    }
+
+
+
+    // Pick a random sprite, avoiding those that are already used unless
+    // every sprite in this category is. Returns the index in INFO, or -1 if
+    // the category is empty.
+    int Category::Pick(Random &random, const StellarObject::UsedSprites &used) const
+    {
+        if(sprites.empty())
+            return -1;
+
+        double column = random.Real() * sprites.size();
+        int i = column;
+        int choice = sprites[(column - i < threshold[i]) ? i : alias[i]];
+        if(!used[choice])
+            return choice;
+
+        // Rather than trying again until an unused sprite comes up, which may
+        // take many tries (or forever, if all of them are used), pick directly
+        // from the unused ones.
+        double remaining = 0.;
+        for(unsigned k = 0; k < sprites.size(); ++k)
+            if(!used[sprites[k]])
+                remaining += weights[k];
+        if(!remaining)
+            return choice;
+
+        double r = random.Real() * remaining;
+        for(unsigned k = 0; k < sprites.size(); ++k)
+            if(!used[sprites[k]])
+            {
+                r -= weights[k];
+                if(r < 0.)
+                    return sprites[k];
+            }
+        // Rounding error may leave r just above zero at the end.
+        for(unsigned k = sprites.size(); k-- > 0; )
+            if(!used[sprites[k]])
+                return sprites[k];
+        return choice;
+    }
+
+
+
+    // Get the planets (not stars or stations) with radii in the given range.
+    auto PlanetWeight(int minRadius, int maxRadius, bool skipHabitable)
+    {
+        return [=](const Info &info) -> double
+        {
+            return (info.radius >= minRadius && info.radius < maxRadius && info.name[0] == 'p'
+                && !(skipHabitable && info.info) && info.info != 3);
+        };
+    }
 }
 
 
@@ -236,8 +494,7 @@ double StellarObject::Period() const
 // Get the radius of this planet, i.e. how close you must be to land.
 double StellarObject::Radius() const
 {
-    auto it = INFO.find(sprite);
-    return (it != INFO.end() ? it->second.radius : 40.);
+    return radius;
 }
 
 
@@ -252,6 +509,15 @@ const QString &StellarObject::GetPlanet() const
 
 
 
+// Get the index of this object's sprite in the table of known sprites, or -1
+// if it is not a known sprite.
+int StellarObject::SpriteId() const
+{
+    return spriteId;
+}
+
+
+
 // Get the index of the parent object.
 int StellarObject::Parent() const
 {
@@ -261,85 +527,78 @@ int StellarObject::Parent() const
 
 
 // Get a random star, based on a probability distribution of stars.
-StellarObject StellarObject::Star()
+StellarObject StellarObject::Star(Random &random)
 {
-    int r = rand() % 100;
-    auto it = INFO.lower_bound("star");
-    while(it != INFO.end() && r >= it->second.info)
+    static const Category stars([](const Info &info) -> double
     {
-        r -= it->second.info;
-        ++it;
-    }
-
-    // This should never happen, because the weights add up to 100. But, just
-    // for the sake of defensive programming:
-    if(it == INFO.end())
-        it = INFO.find("star/wr");
-
-    StellarObject object;
-    object.sprite = it->first;
-    return object;
+        return (info.name[0] == 's' ? info.info : 0.);
+    });
+    return FromTable(stars.Pick(random, UsedSprites()));
 }
 
 
 
 // Get a random "moon." It may also be used as a stand-alone planet.
-StellarObject StellarObject::Moon()
+StellarObject StellarObject::Moon(Random &random, const UsedSprites &used)
 {
-    return Planet(0, MOON_RADIUS);
+    static const Category moons(PlanetWeight(0, MOON_RADIUS, false));
+    return FromTable(moons.Pick(random, used));
 }
 
 
 
 // Get a random (non-giant) planet. It may or may not be habitable.
-StellarObject StellarObject::Planet()
+StellarObject StellarObject::Planet(Random &random, const UsedSprites &used)
 {
-    return Planet(MOON_RADIUS, GIANT_RADIUS);
+    static const Category planets(PlanetWeight(MOON_RADIUS, GIANT_RADIUS, false));
+    return FromTable(planets.Pick(random, used));
 }
 
 
 
 // Get a random planet that can exist outside the habitable zone.
-StellarObject StellarObject::Uninhabited()
+StellarObject StellarObject::Uninhabited(Random &random, const UsedSprites &used)
 {
-    return Planet(MOON_RADIUS, GIANT_RADIUS, true);
+    static const Category uninhabited(PlanetWeight(MOON_RADIUS, GIANT_RADIUS, true));
+    return FromTable(uninhabited.Pick(random, used));
 }
 
 
 
 // Get a random gas giant.
-StellarObject StellarObject::Giant()
+StellarObject StellarObject::Giant(Random &random, const UsedSprites &used)
 {
-    return Planet(GIANT_RADIUS);
+    static const Category giants(PlanetWeight(GIANT_RADIUS, 1000, false));
+    return FromTable(giants.Pick(random, used));
 }
 
 
 
 // Get a random station.
-StellarObject StellarObject::Station()
+StellarObject StellarObject::Station(Random &random, const UsedSprites &used)
 {
-    static int count = 0;
-    if(!count)
+    // Skip stars and anything bigger than a radius of 50 pixels.
+    static const Category stations([](const Info &info) -> double
     {
-        // Skip stars and anything bigger than a radius of 50 pixels.
-        for(const auto &it : INFO)
-            if(it.second.info == 3 && it.first[0] == 'p')
-                ++count;
-    }
+        return (info.info == 3 && info.name[0] == 'p');
+    });
+    return FromTable(stations.Pick(random, used));
+}
 
-    StellarObject object;
-    int r = rand() % count;
-    for(const auto &it : INFO)
-        if(it.second.info == 3 && it.first[0] == 'p')
-        {
-            if(!r)
-            {
-                object.sprite = it.first;
-                break;
-            }
-            --r;
-        }
-    return object;
+
+
+// Get the known sprites that are inhabited, so that they can be treated as
+// used when generating a system that must be uninhabited.
+const StellarObject::UsedSprites &StellarObject::InhabitedSprites()
+{
+    static const UsedSprites inhabited = []()
+    {
+        UsedSprites result;
+        for(int i = 0; i < INFO_COUNT; ++i)
+            result[i] = FromTable(i).IsInhabited();
+        return result;
+    }();
+    return inhabited;
 }
 
 
@@ -347,28 +606,28 @@ StellarObject StellarObject::Station()
 // Check if this is a star.
 bool StellarObject::IsStar() const
 {
-    return sprite.startsWith("star");
+    return flags & STAR;
 }
 
 
 
 bool StellarObject::IsMoon() const
 {
-    return (Radius() < MOON_RADIUS) && !IsStation() && !IsStar();
+    return flags & MOON;
 }
 
 
 
 bool StellarObject::IsTerrestrial() const
 {
-    return !IsMoon() && !IsGiant() && !IsStation() && !IsStar();
+    return !(flags & (STAR | STATION | MOON | GIANT));
 }
 
 
 
 bool StellarObject::IsGiant() const
 {
-    return (Radius() >= GIANT_RADIUS) && !IsStation() && !IsStar();
+    return flags & GIANT;
 }
 
 
@@ -376,20 +635,14 @@ bool StellarObject::IsGiant() const
 // Check if this is a station.
 bool StellarObject::IsStation() const
 {
-    return sprite.startsWith("planet/station");
+    return flags & STATION;
 }
 
 
 
 bool StellarObject::IsInhabited() const
 {
-    if(IsStar())
-        return false;
-    if(IsStation())
-        return true;
-
-    auto it = INFO.find(sprite);
-    return(it != INFO.end() && it->second.info == 2);
+    return flags & INHABITED;
 }
 
 
@@ -408,26 +661,39 @@ void StellarObject::SetPlanet(const QString &name)
 
 
 
-StellarObject StellarObject::Planet(int minRadius, int maxRadius, bool skipHabitable)
+// Make an object with the sprite at the given index in the sprite table.
+StellarObject StellarObject::FromTable(int spriteId)
 {
-    int count = 0;
-    for(const auto &it : INFO)
-        if(it.second.radius >= minRadius && it.second.radius < maxRadius)
-            if(it.first[0] == 'p' && !(skipHabitable && it.second.info) && it.second.info != 3)
-                ++count;
-
+    // An index that is not in the table (i.e. from an empty category) gives
+    // an object with no sprite.
     StellarObject object;
-    int r = rand() % count;
-    for(const auto &it : INFO)
-        if(it.second.radius >= minRadius && it.second.radius < maxRadius)
-            if(it.first[0] == 'p' && !(skipHabitable && it.second.info) && it.second.info != 3)
-            {
-                if(!r)
-                {
-                    object.sprite = it.first;
-                    break;
-                }
-                --r;
-            }
+    if(spriteId >= 0 && spriteId < INFO_COUNT)
+        object.SetSprite(INFO[spriteId].name);
     return object;
 }
+
+
+
+// Change the sprite, and look up everything about the object that depends on
+// which sprite it is, so that none of that has to be looked up again.
+void StellarObject::SetSprite(const QString &name)
+{
+    sprite = name;
+    spriteId = FindSprite(sprite);
+    radius = (spriteId >= 0 ? INFO[spriteId].radius : DEFAULT_RADIUS);
+
+    flags = 0;
+    if(sprite.startsWith("star"))
+        flags = STAR;
+    else if(sprite.startsWith("planet/station"))
+        flags = STATION | INHABITED;
+    else
+    {
+        if(spriteId >= 0 && INFO[spriteId].info == 2)
+            flags |= INHABITED;
+        if(radius < MOON_RADIUS)
+            flags |= MOON;
+        else if(radius >= GIANT_RADIUS)
+            flags |= GIANT;
+    }
+}
@@ -19,8 +19,11 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <QVector2D>
 #include <QString>
 
+#include <bitset>
+#include <cstdint>
 #include <vector>
 
+class Random;
 class System;
 
 
@@ -31,6 +34,12 @@ class System;
 // orbiting around and how far away it is from that object. Each day, all the
 // objects in each system move slightly in their orbits.
 class StellarObject {
+public:
+    // A set of sprites, marked by their SpriteId(), e.g. the ones that are
+    // already used in a system.
+    typedef std::bitset<256> UsedSprites;
+
+
 public:
     StellarObject() = default;
     StellarObject(int parent) : parent(parent) {};
@@ -52,21 +61,29 @@ public:
     // function will just return nullptr.
     const QString &GetPlanet() const;
 
+    // Get the index of this object's sprite in the table of known sprites, or -1
+    // if it is not a known sprite.
+    int SpriteId() const;
     // Get the index of the parent object.
     int Parent() const;
 
     // Get a random star, based on a probability distribution of stars.
-    static StellarObject Star();
+    static StellarObject Star(Random &random);
     // Get a random "moon." It may also be used as a stand-alone planet.
-    static StellarObject Moon();
+    // These all avoid picking any of the given sprites, unless all of the
+    // sprites of that kind are used already.
+    static StellarObject Moon(Random &random, const UsedSprites &used = UsedSprites());
     // Get a random (non-giant) planet. It may or may not be habitable.
-    static StellarObject Planet();
+    static StellarObject Planet(Random &random, const UsedSprites &used = UsedSprites());
     // Get a random planet that can exist outside the habitable zone.
-    static StellarObject Uninhabited();
+    static StellarObject Uninhabited(Random &random, const UsedSprites &used = UsedSprites());
     // Get a random gas giant.
-    static StellarObject Giant();
+    static StellarObject Giant(Random &random, const UsedSprites &used = UsedSprites());
     // Get a random station.
-    static StellarObject Station();
+    static StellarObject Station(Random &random, const UsedSprites &used = UsedSprites());
+    // Get the known sprites that are inhabited, so that they can be treated as
+    // used when generating a system that must be uninhabited.
+    static const UsedSprites &InhabitedSprites();
 
     // Check if this is a star.
     bool IsStar() const;
@@ -87,12 +104,34 @@ public:
 
 
 private:
-    static StellarObject Planet(int minRadius, int maxRadius = 1000, bool skipHabitable = false);
+    // Make an object with the sprite at the given index in the sprite table.
+    static StellarObject FromTable(int spriteId);
+    // Change the sprite, and look up everything about the object that depends
+    // on which sprite it is.
+    void SetSprite(const QString &name);
+
+
+private:
+    // What sort of object this is, based on its sprite.
+    enum : uint8_t {
+        STAR = 1,
+        STATION = 2,
+        MOON = 4,
+        GIANT = 8,
+        INHABITED = 16
+    };
+    // Any sprite that is not in the table of known sprites gets this radius.
+    static constexpr double DEFAULT_RADIUS = 40.;
 
 
 private:
     QString sprite;
     std::list<DataNode> spriteProperties;
+    // Everything that depends on the sprite is found once, when it is set.
+    int spriteId = -1;
+    double radius = DEFAULT_RADIUS;
+    // An object with no sprite has the default radius, which is a moon's.
+    uint8_t flags = MOON;
 
     QVector2D position;
     QString planet;
@@ -14,15 +14,18 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "DataNode.h"
 #include "DataWriter.h"
-#include "pi.h"
+#include "OrbitPropagator.h"
 #include "Planet.h"
+#include "Random.h"
 
 #include <QString>
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <limits>
 #include <set>
+#include <unordered_map>
 
 using namespace std;
 
@@ -38,6 +41,19 @@ namespace {
     static const int RANDOM_STAR_DISTANCE = 40;
     static const double MIN_STAR_DISTANCE = 40.;
 
+    // Random systems are filled with planets out to this radius.
+    static const double FULL_RADIUS = 2000.;
+    // How far a terrestrial planet's moon and station can reach from its
+    // center, at most.
+    static const double HABITABLE_REACH = 450.;
+    // How many stars to try, at most, to find one with room for a habitable
+    // planet between it and the habitable zone's outer edge.
+    static const int STAR_TRIES = 10;
+
+    // Revision numbers are shared by all systems, so that a copy of a system
+    // that is later changed can never be mistaken for the original.
+    atomic<unsigned> lastRevision;
+
     struct StarData {
         StarData(QString name, double habitable, double mass) : name(name), habitable(habitable), mass(mass) {}
         StarData() = delete;
@@ -143,6 +159,25 @@ namespace {
         // Default value for systems without a known star.
         {"default", 100., 100.}
     }};
+
+    // Get how much the object with the given sprite adds to the mass that the
+    // planets orbit around. Only stars and rogue bodies have any mass. The
+    // stars are looked up by name in a hash table built from the list above.
+    double SpriteMass(const QString &sprite)
+    {
+        if(!((sprite.startsWith("star/") && !sprite.contains("-core")) || sprite.contains("rogue")))
+            return 0.;
+
+        static const unordered_map<QString, const StarData *> index = []()
+        {
+            unordered_map<QString, const StarData *> result;
+            for(const StarData &star : stars)
+                result.emplace(star.name, &star);
+            return result;
+        }();
+        const auto it = index.find(sprite.section('/', 1));
+        return (it == index.end() ? stars.back() : *it->second).Mass();
+    }
 }
 
 
@@ -152,6 +187,7 @@ void System::Load(const DataNode &node)
     if(node.Size() < 2)
         return;
     trueName = node.Token(1);
+    sourceLine = node.LineNumber();
 
     habitable = numeric_limits<double>::quiet_NaN();
 
@@ -262,6 +298,7 @@ void System::Load(const DataNode &node)
         else
             unparsed.push_back(child);
     }
+    Revise();
 }
 
 
@@ -380,6 +417,30 @@ void System::Save(DataWriter &file) const
 
 
 
+// Get the hash of the data node this system is saved as. This is the same as
+// the DataNode::Hash() of the node it was loaded from if nothing changed,
+// as long as that file was last saved by the editor.
+uint64_t System::Hash() const
+{
+    uint64_t hash = DataNode::EMPTY_HASH;
+    {
+        DataWriter file(&hash);
+        Save(file);
+    }
+    return hash;
+}
+
+
+
+// Get the line of the map file this system was loaded from, or 0 if it
+// was not loaded from a file.
+int System::SourceLine() const
+{
+    return sourceLine;
+}
+
+
+
 const QString &System::TrueName() const
 {
     return trueName;
@@ -534,6 +595,40 @@ double System::OccupiedRadius() const
 
 
 
+// Get the band occupied by each primary object, in order. These are only
+// recomputed when the objects change.
+const vector<System::Ring> &System::OccupiedRings() const
+{
+    if(ringRevision == revision)
+        return rings;
+    ringRevision = revision;
+
+    // Unlike OccupiedRadius(), this finds every object's zone in one pass.
+    // Every moon comes after its parent, so its parent's ring already exists.
+    rings.clear();
+    vector<int> ringIndex(objects.size(), -1);
+    for(unsigned i = 0; i < objects.size(); ++i)
+    {
+        const StellarObject &object = objects[i];
+        if(object.Parent() < 0 && !object.IsStar())
+        {
+            ringIndex[i] = rings.size();
+            rings.push_back({object.Distance(), object.Radius()});
+        }
+        else if(object.Parent() >= 0 && ringIndex[object.Parent()] >= 0)
+        {
+            double &width = rings[ringIndex[object.Parent()]].width;
+            width = max(width, object.Distance() + object.Radius());
+        }
+    }
+    // So far each width is only the distance out from the ring's center.
+    for(Ring &ring : rings)
+        ring.width *= 2.;
+    return rings;
+}
+
+
+
 double System::StarRadius() const
 {
     double radius = 0.;
@@ -548,6 +643,48 @@ double System::StarRadius() const
 
 
 
+// Find every place where the objects break the spacing rules. These are the
+// same rules that Move() enforces, but a system loaded from a file may have
+// been edited by hand.
+vector<System::SpacingError> System::SpacingErrors() const
+{
+    vector<SpacingError> errors;
+    const vector<Ring> &rings = OccupiedRings();
+    unsigned ring = 0;
+    // The outer edge of the last zone, starting with the stars.
+    double previous = StarRadius();
+    bool isFirst = true;
+    for(unsigned i = 0; i < objects.size(); ++i)
+    {
+        const StellarObject &object = objects[i];
+        if(object.IsStar())
+            continue;
+
+        if(object.Parent() < 0)
+        {
+            const Ring &zone = rings[ring++];
+            double gap = zone.radius - .5 * zone.width - previous;
+            if(gap < MIN_GAP)
+                errors.push_back({isFirst ? SpacingError::STAR_GAP : SpacingError::ZONE_GAP,
+                    static_cast<int>(i), MIN_GAP - gap});
+            previous = zone.radius + .5 * zone.width;
+            isFirst = false;
+        }
+        else
+        {
+            const StellarObject &inside = objects[i - 1];
+            double gap = object.Distance() - object.Radius() - inside.Radius();
+            if(inside.Parent() >= 0)
+                gap -= inside.Distance();
+            if(gap < MIN_MOON_GAP)
+                errors.push_back({SpacingError::MOON_GAP, static_cast<int>(i), MIN_MOON_GAP - gap});
+        }
+    }
+    return errors;
+}
+
+
+
 bool System::HasRamscoopUniversal() const
 {
     return ramscoopUniversal;
@@ -590,6 +727,13 @@ const vector<System::Minable> &System::Minables() const
 
 
 
+const vector<System::Belt> &System::Belts() const
+{
+    return belts;
+}
+
+
+
 int System::Trade(const QString &commodity) const
 {
     auto it = trade.find(commodity);
@@ -598,6 +742,14 @@ int System::Trade(const QString &commodity) const
 
 
 
+// Get the prices of all the commodities that are traded here.
+const map<QString, int> &System::Trades() const
+{
+    return trade;
+}
+
+
+
 vector<PeriodicEvent> &System::Fleets()
 {
     return fleets;
@@ -647,35 +799,38 @@ const vector<System::RaidFleet> &System::RaidFleets() const
 
 
 
-// Position the planets, etc.
+// Position the planets, etc. This packs the orbits into a new propagator
+// each time, so anything that animates a system should keep its own.
 void System::SetDay(double day)
 {
-    timeStep = day;
-    for(StellarObject &object : objects)
-    {
-        double angle = (!object.period ? 0. : day * 360. / object.period) + object.offset;
-        angle *= TO_RAD;
+    OrbitPropagator propagator;
+    propagator.Add(*this);
+    propagator.Propagate(day);
+    propagator.Apply(*this, 0);
+}
 
-        object.position = object.distance * QVector2D(sin(angle), -cos(angle));
 
-        // Because of the order of the vector, the parent's position has always
-        // been updated before this loop reaches any of its children, so:
-        if(object.parent >= 0)
-            object.position += objects[object.parent].position;
-    }
+
+// Move the objects to positions found elsewhere for the given day, e.g. by
+// an OrbitPropagator. The positions are offsets from the system's center.
+void System::SetPositions(double day, const float *x, const float *y)
+{
+    timeStep = day;
+    for(unsigned i = 0; i < objects.size(); ++i)
+        objects[i].position = QVector2D(x[i], y[i]);
 }
 
 
 
-void System::Init(const QString &name, const QVector2D &position)
+void System::Init(const QString &name, const QVector2D &position, Random &random)
 {
     trueName = name;
     displayName = name;
     this->position = position;
 
-    Randomize(true, false);
-    ChangeAsteroids();
-    ChangeMinables();
+    Randomize(true, false, random);
+    ChangeAsteroids(random);
+    ChangeMinables(random);
 }
 
 
@@ -687,7 +842,7 @@ void System::SetTrueName(const QString &name)
 
 
 
-void System::SetDisplayName(const QString &name)
+void System::SetDisplayName(const optional<QString> &name)
 {
     displayName = name;
 }
@@ -756,6 +911,14 @@ void System::ChangeLink(const QString &from, const QString &to)
 
 
 
+// Add a link to the given system, without changing that system's links.
+void System::AddLink(const QString &name)
+{
+    links.insert(name);
+}
+
+
+
 void System::SetJumpRange(double value)
 {
     jumpRange = value;
@@ -877,22 +1040,23 @@ void System::Move(StellarObject *object, double dDistance, double dAngle)
             it->distance += dDistance;
             Recompute(*it);
         }
+    Revise();
 }
 
 
 
-void System::ChangeAsteroids()
+void System::ChangeAsteroids(Random &random)
 {
     asteroids.clear();
 
     // Pick the total number of asteroids. Bias towards small numbers, with
     // a few systems with many more.
-    int fullTotal = (rand() % 21) * (rand() % 21) + 1;
-    double energy = (rand() % 21 + 10) * (rand() % 21 + 10) * .01;
+    int fullTotal = random.Int(21) * random.Int(21) + 1;
+    double energy = (random.Int(21) + 10) * (random.Int(21) + 10) * .01;
     const QString suffix[2] = {" rock", " metal"};
     const QString prefix[3] = {"small", "medium", "large"};
 
-    int total[2] = {rand() % fullTotal, 0};
+    int total[2] = {random.Int(fullTotal), 0};
     total[1] = fullTotal - total[0];
 
     for(int i = 0; i < 2; ++i)
@@ -900,11 +1064,11 @@ void System::ChangeAsteroids()
         if(!total[i])
             continue;
 
-        int count[3] = {0, rand() % total[i], 0};
+        int count[3] = {0, random.Int(total[i]), 0};
         int remaining = total[i] - count[1];
         if(remaining)
         {
-            count[0] = rand() % remaining;
+            count[0] = random.Int(remaining);
             count[2] = remaining - count[0];
         }
 
@@ -913,17 +1077,17 @@ void System::ChangeAsteroids()
                 asteroids.emplace_back(
                     prefix[j] + suffix[i],
                     count[j],
-                    energy * (rand() % 101 + 50) * .01);
+                    energy * (random.Int(101) + 50) * .01);
     }
 }
 
 
 
-void System::ChangeMinables()
+void System::ChangeMinables(Random &random)
 {
     // First, change the belt radius.
     belts.clear();
-    belts.emplace_back(rand() % 1000 + 1000);
+    belts.emplace_back(random.Int(1000) + 1000);
     minables.clear();
 
     // Next, figure out the quantity and energy of the ordinary asteroids.
@@ -961,11 +1125,11 @@ void System::ChangeMinables()
     for(int i = 0; i < 3; ++i)
     {
         // Pick three random minable types, with decreasing quantities.
-        totalCount = rand() % (totalCount + 1);
+        totalCount = random.Int(totalCount + 1);
         if(!totalCount)
             break;
 
-        int choice = rand() % 100;
+        int choice = random.Int(100);
         for(const auto &it : probability)
         {
             choice -= it.second;
@@ -978,15 +1142,16 @@ void System::ChangeMinables()
     }
     for(const auto &it : choices)
     {
-        double energy = (rand() % 1000 + 1000) * .001 * meanEnergy;
+        double energy = (random.Int(1000) + 1000) * .001 * meanEnergy;
         minables.emplace_back(it.first, it.second, energy);
     }
 }
 
 
 
-void System::ChangeStar()
+void System::ChangeStar(Random &random)
 {
+    starMass = -1.;
     double oldStarRadius = StarRadius();
     unsigned oldStars = 0;
     while(!objects.empty() && objects.front().IsStar())
@@ -996,7 +1161,7 @@ void System::ChangeStar()
     }
 
     // If the number of stars is changing, all parent indices change.
-    unsigned stars = 1 + !(rand() % 3);
+    unsigned stars = 1 + !random.Int(3);
     if(stars != oldStars)
         for(StellarObject &object : objects)
             if(object.parent >= 0)
@@ -1005,7 +1170,7 @@ void System::ChangeStar()
     double mass = 0.;
     if(stars == 1)
     {
-        StellarObject star = StellarObject::Star();
+        StellarObject star = StellarObject::Star(random);
         star.system = this;
         star.period = 10.;
         mass = pow(star.Radius(), 3.) * STAR_MASS_SCALE;
@@ -1014,8 +1179,8 @@ void System::ChangeStar()
     }
     else
     {
-        StellarObject first = StellarObject::Star();
-        StellarObject second = StellarObject::Star();
+        StellarObject first = StellarObject::Star(random);
+        StellarObject second = StellarObject::Star(random);
         first.system = this;
         second.system = this;
         first.offset = 0.;
@@ -1027,7 +1192,7 @@ void System::ChangeStar()
         double secondMass = pow(secondR, 3.) * STAR_MASS_SCALE;
         mass = firstMass + secondMass;
 
-        double distance = firstR + secondR + (rand() % RANDOM_STAR_DISTANCE) + MIN_STAR_DISTANCE;
+        double distance = firstR + secondR + random.Int(RANDOM_STAR_DISTANCE) + MIN_STAR_DISTANCE;
         // m1 * d1 = m2 * d2
         // d1 + d2 = d;
         // m1 * d1 = m2 * (d - d1)
@@ -1052,37 +1217,37 @@ void System::ChangeStar()
         double newStarRadius = StarRadius();
         Move(&objects[stars], newStarRadius - oldStarRadius);
     }
+    Revise();
 }
 
 
 
-void System::ChangeSprite(StellarObject *object)
+void System::ChangeSprite(StellarObject *object, Random &random)
 {
     if(!object || object < &objects.front() || object > &objects.back())
         return;
 
     StellarObject newObject;
-    set<QString> used = Used();
-    do {
-        if(object->IsStation())
-            newObject = StellarObject::Station();
-        else if(object->IsMoon())
-            newObject = StellarObject::Moon();
-        else if(object->IsGiant())
-            newObject = StellarObject::Giant();
+    StellarObject::UsedSprites used = Used();
+    if(object->IsStation())
+        newObject = StellarObject::Station(random, used);
+    else if(object->IsMoon())
+        newObject = StellarObject::Moon(random, used);
+    else if(object->IsGiant())
+        newObject = StellarObject::Giant(random, used);
+    else
+    {
+        double distance = (object->Parent() >= 0 ? objects[object->Parent()].Distance() : object->Distance());
+        if(distance >= .5 * habitable && distance < 2. * habitable)
+            newObject = StellarObject::Planet(random, used);
         else
-        {
-            double distance = (object->Parent() >= 0 ? objects[object->Parent()].Distance() : object->Distance());
-            if(distance >= .5 * habitable && distance < 2. * habitable)
-                newObject = StellarObject::Planet();
-            else
-                newObject = StellarObject::Uninhabited();
-        }
-    } while(used.count(newObject.Sprite()));
+            newObject = StellarObject::Uninhabited(random, used);
+    }
 
     // Check how much the radius will change by, then change the sprite.
     double radiusChange = newObject.Radius() - object->Radius();
-    object->sprite = newObject.sprite;
+    object->SetSprite(newObject.sprite);
+    starMass = -1.;
 
     // If this object has a parent:
     // this distance += dRadius
@@ -1129,79 +1294,19 @@ void System::ChangeSprite(StellarObject *object)
             Recompute(*it);
         }
     }
+    Revise();
 }
 
 
 
-void System::AddPlanet()
+void System::AddPlanet(Random &random)
 {
-    // The spacing between planets grows exponentially.
-    int randomPlanetSpace = RANDOM_GAP;
-    for(const StellarObject &object : objects)
-        if(!object.IsStar() && object.Parent() < 0)
-            randomPlanetSpace += randomPlanetSpace / 2;
-
-    double distance = OccupiedRadius();
-    int space = rand() % randomPlanetSpace;
-    distance += (space * space) * .01 + MIN_GAP;
-
-    set<QString> used = Used();
-
-    StellarObject root;
-    int rootIndex = static_cast<int>(objects.size());
-
-    bool isHabitable = (distance > habitable * .5 && distance < habitable * 2. - 120.);
-    bool isSmall = !(rand() % 10);
-    bool isTerrestrial = !isSmall && (rand() % 2000 > distance);
-
-    // Occasionally, moon-sized objects can be root objects. Otherwise, pick a
-    // giant or a normal planet, with giants more frequent in the outer parts
-    // of the solar system.
-    do {
-        if(isSmall)
-            root = StellarObject::Moon();
-        else if(isTerrestrial)
-            root = isHabitable ? StellarObject::Planet() : StellarObject::Uninhabited();
-        else
-            root = StellarObject::Giant();
-    } while(used.count(root.Sprite()));
-    objects.push_back(root);
-    objects.back().system = this;
-    used.insert(root.Sprite());
-
-    int moonCount = rand() % (isTerrestrial ? (rand() % 2 + 1) : (rand() % 3 + 3));
-    if(root.Radius() < 70)
-        moonCount = 0;
-
-    double moonDistance = root.Radius();
-    int randomMoonSpace = RANDOM_MOON_GAP;
-    for(int i = 0; i < moonCount; ++i)
-    {
-        moonDistance += rand() % randomMoonSpace + MIN_MOON_GAP;
-        // Each moon, on average, should be spaced more widely than the one before.
-        randomMoonSpace += 20;
-
-        // Use a moon sprite only once per system.
-        StellarObject moon;
-        do {
-            moon = StellarObject::Moon();
-        } while(used.count(moon.Sprite()));
-        used.insert(moon.Sprite());
-
-        moon.distance = moonDistance + moon.Radius();
-        moon.parent = rootIndex;
-        Recompute(moon, false);
-        objects.push_back(moon);
-        objects.back().system = this;
-        moonDistance += 2. * moon.Radius();
-    }
-    objects[rootIndex].distance = distance + moonDistance;
-    Recompute(objects[rootIndex], false);
+    AddPlanet(random, ANY_PLANET, StellarObject::UsedSprites());
 }
 
 
 
-void System::AddMoon(StellarObject *object, bool isStation)
+void System::AddMoon(StellarObject *object, Random &random, bool isStation)
 {
     if(!object || object < &objects.front() || object > &objects.back())
         return;
@@ -1217,12 +1322,9 @@ void System::AddMoon(StellarObject *object, bool isStation)
         ++it;
     }
 
-    double moonDistance = originalMoonDistance + rand() % randomMoonSpace + MIN_MOON_GAP;
-    set<QString> used = Used();
-    StellarObject moon;
-    do {
-        moon = isStation ? StellarObject::Station() : StellarObject::Moon();
-    } while(used.count(moon.Sprite()));
+    double moonDistance = originalMoonDistance + random.Int(randomMoonSpace) + MIN_MOON_GAP;
+    StellarObject::UsedSprites used = Used();
+    StellarObject moon = isStation ? StellarObject::Station(random, used) : StellarObject::Moon(random, used);
 
     moon.distance = moonDistance + moon.Radius();
     moon.parent = rootIndex;
@@ -1244,36 +1346,146 @@ void System::AddMoon(StellarObject *object, bool isStation)
     for( ; it != objects.end(); ++it)
         if(it->parent > rootIndex)
             ++it->parent;
+    Revise();
 }
 
 
 
-void System::Randomize(bool allowHabitable, bool requireHabitable)
+bool System::Randomize(bool allowHabitable, bool requireHabitable, Random &random)
 {
-    // Try to create a system satisfying the given parameters.
-    for(int i = 0; i < 100; ++i)
+    Constraints constraints;
+    constraints.allowInhabited = allowHabitable;
+    constraints.requireHabitable = requireHabitable;
+    return Randomize(constraints, random);
+}
+
+
+
+// Generate new stellar objects that meet the given constraints, as closely
+// as they can be met, without ever retrying. Rather than generating whole
+// systems until one happens to fit, each planet is chosen to fit: the orbit of
+// the required habitable planet is picked first, planets are only added inside
+// it if they leave room for it, and which planets are giants is chosen to make
+// the right number of them. Return false if the constraints could not all be
+// met: no star left room for a required habitable planet, or there are no
+// planets for a required habitable planet or station to be.
+bool System::Randomize(const Constraints &constraints, Random &random)
+{
+    // Inhabited sprites are kept out by treating them as if they were used.
+    StellarObject::UsedSprites excluded;
+    if(!constraints.allowInhabited)
+        excluded = StellarObject::InhabitedSprites();
+
+    bool needsHabitable = constraints.requireHabitable && constraints.planets != 0;
+    int planets = constraints.planets;
+    int giants = constraints.giants;
+    if(planets >= 0 && giants > planets - needsHabitable)
+        giants = planets - needsHabitable;
+
+    // If a habitable planet is required, pick a star with room for it. If none
+    // of them has room, keep the one that comes closest.
+    objects.clear();
+    ChangeStar(random);
+    if(needsHabitable)
     {
-        objects.clear();
-        ChangeStar();
-        while(OccupiedRadius() < 2000.)
-            AddPlanet();
+        auto room = [this]()
+        {
+            return 2. * habitable - (StarRadius() + MIN_GAP + HABITABLE_REACH);
+        };
+        vector<StellarObject> bestStars = objects;
+        double bestHabitable = habitable;
+        double bestRoom = room();
+        for(int i = 1; i < STAR_TRIES && bestRoom <= 0.; ++i)
+        {
+            ChangeStar(random);
+            if(room() > bestRoom)
+            {
+                bestStars = objects;
+                bestHabitable = habitable;
+                bestRoom = room();
+            }
+        }
+        if(room() < bestRoom)
+            SetObjects(bestStars, bestHabitable);
+    }
+    bool isMet = (needsHabitable == constraints.requireHabitable);
 
-        bool isInhabited = false;
-        bool isHabitable = false;
-        for(const StellarObject &object : objects)
+    int placed = 0;
+    int giantCount = 0;
+    auto add = [&](PlanetKind kind, double minDistance = 0., bool withStation = false)
+    {
+        AddPlanet(random, kind, excluded, minDistance, withStation);
+        ++placed;
+        for(auto it = objects.rbegin(); it != objects.rend(); ++it)
+            if(it->Parent() < 0)
+            {
+                giantCount += it->IsGiant();
+                break;
+            }
+    };
+    // Only pick a giant or not if the giant count requires it.
+    auto nextKind = [&]()
+    {
+        if(giants < 0)
+            return ANY_PLANET;
+        int missing = giants - giantCount;
+        if(missing <= 0)
+            return NOT_GIANT;
+        if(planets >= 0 && missing >= planets - placed - needsHabitable)
+            return GIANT_PLANET;
+        return ANY_PLANET;
+    };
+    auto isFull = [&]()
+    {
+        return (planets >= 0 ? placed >= planets : OccupiedRadius() >= FULL_RADIUS);
+    };
+
+    if(needsHabitable)
+    {
+        // Pick where the habitable planet will go, as far out in the habitable
+        // zone as the stars leave room for.
+        double low = max(.5 * habitable, StarRadius() + MIN_GAP + HABITABLE_REACH);
+        double target = low + random.Real() * max(0., 2. * habitable - low);
+
+        // Add planets inside it until one of them does not leave enough room.
+        while(planets < 0 || placed < planets - 1)
         {
-            isInhabited |= object.IsInhabited();
-            double d = object.Distance();
-            isHabitable |= object.Parent() < 0 && object.IsTerrestrial()
-                && d > .5 * habitable && d < 2. * habitable;
+            size_t size = objects.size();
+            add(nextKind());
+            if(OccupiedRadius() + MIN_GAP + HABITABLE_REACH <= target)
+                continue;
+
+            --placed;
+            giantCount -= objects[size].IsGiant();
+            objects.erase(objects.begin() + size, objects.end());
+            break;
         }
-        if(isInhabited && !allowHabitable)
-            continue;
-        if(!isHabitable && requireHabitable)
-            continue;
-        break;
+        size_t index = objects.size();
+        add(HABITABLE_PLANET, target, constraints.requireStation);
+        isMet &= (objects[index].Distance() < 2. * habitable);
+    }
+    while(!isFull())
+        add(nextKind());
+    // If the system is full but is still missing giants, add them farther out.
+    while(planets < 0 && giantCount < giants)
+        add(GIANT_PLANET);
+
+    // Any station that is still needed goes around the outermost planet, so
+    // that nothing else has to move to make room for it.
+    if(constraints.requireStation && !needsHabitable)
+    {
+        auto it = objects.rbegin();
+        while(it != objects.rend() && (it->Parent() >= 0 || it->IsStar()))
+            ++it;
+        if(it != objects.rend())
+            AddMoon(&*it, random, true);
+        else
+            isMet = false;
     }
+
     UpdateObjectPointers();
+    Revise();
+    return isMet;
 }
 
 
@@ -1298,6 +1510,8 @@ void System::Delete(StellarObject *object)
     }
     int parentShift = end - it;
     objects.erase(it, end);
+    starMass = -1.;
+    Revise();
 
     it = objects.begin() + index;
     if(it == objects.end())
@@ -1311,6 +1525,65 @@ void System::Delete(StellarObject *object)
 
 
 
+// Get the orbits of all objects from the given index onward.
+vector<System::Orbit> System::Orbits(int first) const
+{
+    vector<Orbit> orbits;
+    for(unsigned i = max(first, 0); i < objects.size(); ++i)
+        orbits.push_back({objects[i].distance, objects[i].period, objects[i].offset});
+    return orbits;
+}
+
+
+
+// Restore the orbits of the objects from the given index onward.
+void System::SetOrbits(int first, const vector<Orbit> &orbits)
+{
+    for(unsigned i = 0; i < orbits.size() && first + i < objects.size(); ++i)
+    {
+        StellarObject &object = objects[first + i];
+        object.distance = orbits[i].distance;
+        object.period = orbits[i].period;
+        object.offset = orbits[i].offset;
+    }
+    Revise();
+}
+
+
+
+// Replace all the objects in this system, and the habitable zone that goes
+// with them.
+void System::SetObjects(const vector<StellarObject> &newObjects, double newHabitable)
+{
+    objects = newObjects;
+    habitable = newHabitable;
+    starMass = -1.;
+    UpdateObjectPointers();
+    Revise();
+}
+
+
+
+// Replace the asteroids, the minables, and the belts they orbit on.
+void System::SetAsteroids(const vector<Asteroid> &newAsteroids, const vector<Minable> &newMinables,
+    const vector<Belt> &newBelts)
+{
+    asteroids = newAsteroids;
+    minables = newMinables;
+    belts = newBelts;
+}
+
+
+
+// Get a number that changes whenever the stellar objects or their orbits
+// do, so that anything derived from them can be cached.
+unsigned System::Revision() const
+{
+    return revision;
+}
+
+
+
 void System::UpdateObjectPointers()
 {
     for(StellarObject &object : objects)
@@ -1334,7 +1607,8 @@ void System::LoadObject(const DataNode &node, int parent)
     {
         if(child.Token(0) == "sprite" && child.Size() >= 2)
         {
-            object.sprite = child.Token(1);
+            object.SetSprite(child.Token(1));
+            starMass = -1.;
             for(const DataNode &grand : child)
                 object.spriteProperties.emplace_back(grand);
         }
@@ -1408,20 +1682,9 @@ void System::Recompute(StellarObject &object, bool updateOffset)
 {
     if(object.sprite.startsWith("star/") || object.sprite.contains("rogue"))
         return;
-    double mass = 0.;
-    for(const auto &stellar : objects)
-    {
-        if((stellar.sprite.startsWith("star/") && !stellar.sprite.contains("-core")) || stellar.sprite.contains("rogue"))
-        {
-            const QString name = stellar.sprite.section('/', 1);
-            const auto it = std::find_if(stars.begin(), stars.end(),
-                [&name](const StarData &it) -> bool { return it.name == name; });
-            const StarData &star = (it == stars.end() ? stars.back() : *it);
-            mass += star.Mass();
-        }
-    }
     if(object.Parent() >= 0.)
         return; //mass = pow(objects[object.Parent()].Radius(), 3.) * PLANET_MASS_SCALE;
+    double mass = StarMass();
 
     double d = object.distance;
     if(object.sprite.contains("panel"))
@@ -1438,10 +1701,122 @@ void System::Recompute(StellarObject &object, bool updateOffset)
 
 
 
-set<QString> System::Used() const
+// Give the system a new revision number after its objects change.
+void System::Revise()
+{
+    revision = ++lastRevision;
+}
+
+
+
+// Get the total mass of the stars, finding it again only if any of them have
+// changed since the last time.
+double System::StarMass()
+{
+    if(starMass < 0.)
+    {
+        starMass = 0.;
+        for(const StellarObject &object : objects)
+            starMass += SpriteMass(object.sprite);
+    }
+    return starMass;
+}
+
+
+
+// Add a primary planet of the given kind beyond all the other objects,
+// never closer to the star than the given distance, without using any
+// of the given sprites. It may be given a station as its outermost moon.
+void System::AddPlanet(Random &random, PlanetKind kind, const StellarObject::UsedSprites &excluded,
+    double minDistance, bool withStation)
+{
+    // The spacing between planets grows exponentially. A habitable planet
+    // is placed as close as it can be, because its distance is given.
+    int randomPlanetSpace = RANDOM_GAP;
+    for(const StellarObject &object : objects)
+        if(!object.IsStar() && object.Parent() < 0)
+            randomPlanetSpace += randomPlanetSpace / 2;
+
+    double distance = OccupiedRadius();
+    int space = (kind == HABITABLE_PLANET ? 0 : random.Int(randomPlanetSpace));
+    distance += (space * space) * .01 + MIN_GAP;
+
+    StellarObject::UsedSprites used = Used() | excluded;
+
+    StellarObject root;
+    int rootIndex = static_cast<int>(objects.size());
+
+    bool isHabitable = (distance > habitable * .5 && distance < habitable * 2. - 120.);
+    bool isSmall = !random.Int(10);
+    bool isTerrestrial = !isSmall && (random.Int(2000) > distance);
+    if(kind == HABITABLE_PLANET)
+    {
+        isHabitable = true;
+        isSmall = false;
+        isTerrestrial = true;
+    }
+    else if(kind == GIANT_PLANET)
+        isSmall = isTerrestrial = false;
+    else if(kind == NOT_GIANT)
+        isTerrestrial |= !isSmall;
+
+    // Occasionally, moon-sized objects can be root objects. Otherwise, pick a
+    // giant or a normal planet, with giants more frequent in the outer parts
+    // of the solar system.
+    if(isSmall)
+        root = StellarObject::Moon(random, used);
+    else if(isTerrestrial)
+        root = isHabitable ? StellarObject::Planet(random, used) : StellarObject::Uninhabited(random, used);
+    else
+        root = StellarObject::Giant(random, used);
+    objects.push_back(root);
+    objects.back().system = this;
+    used.set(root.SpriteId());
+
+    int moonCount = random.Int(isTerrestrial ? (random.Int(2) + 1) : (random.Int(3) + 3));
+    if(root.Radius() < 70)
+        moonCount = 0;
+
+    double moonDistance = root.Radius();
+    int randomMoonSpace = RANDOM_MOON_GAP;
+    auto addMoon = [&](StellarObject moon)
+    {
+        moon.distance = moonDistance + moon.Radius();
+        moon.parent = rootIndex;
+        Recompute(moon, false);
+        objects.push_back(moon);
+        objects.back().system = this;
+        moonDistance += 2. * moon.Radius();
+    };
+    for(int i = 0; i < moonCount; ++i)
+    {
+        moonDistance += random.Int(randomMoonSpace) + MIN_MOON_GAP;
+        // Each moon, on average, should be spaced more widely than the one before.
+        randomMoonSpace += 20;
+
+        // Use a moon sprite only once per system.
+        StellarObject moon = StellarObject::Moon(random, used);
+        used.set(moon.SpriteId());
+        addMoon(moon);
+    }
+    // Stations are always inhabited, so they ignore the excluded sprites.
+    if(withStation)
+    {
+        moonDistance += random.Int(randomMoonSpace) + MIN_MOON_GAP;
+        addMoon(StellarObject::Station(random, Used()));
+    }
+    objects[rootIndex].distance = max(distance + moonDistance, minDistance);
+    Recompute(objects[rootIndex], false);
+    Revise();
+}
+
+
+
+StellarObject::UsedSprites System::Used() const
 {
-    set<QString> used;
+    StellarObject::UsedSprites used;
     for(const StellarObject &object : objects)
-        used.insert(object.Sprite());
+        if(object.SpriteId() >= 0)
+            used.set(object.SpriteId());
     return used;
 }
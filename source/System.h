@@ -19,6 +19,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <QVector2D>
 #include <QString>
 
+#include <cstdint>
 #include <map>
 #include <optional>
 #include <set>
@@ -27,6 +28,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 class DataNode;
 class DataWriter;
 class Planet;
+class Random;
 
 
 
@@ -59,11 +61,50 @@ public:
         double minimumAttraction = 2.;
         double maximumAttraction = 0.;
     };
+    // The band around the star that a primary object and everything orbiting
+    // it sweep through: a circle of the given radius, and its width.
+    struct Ring {
+        double radius;
+        double width;
+    };
+    // The parts of a stellar object's orbit that dragging it can change.
+    struct Orbit {
+        double distance;
+        double period;
+        double offset;
+    };
+    // What a randomly generated system must have. A negative count means any
+    // number. Stations are always inhabited, so a required station is added
+    // even if inhabited objects are not allowed.
+    struct Constraints {
+        bool allowInhabited = true;
+        bool requireHabitable = false;
+        bool requireStation = false;
+        int planets = -1;
+        int giants = -1;
+    };
+    // A place where the objects are closer together than dragging them would
+    // allow: a primary object whose zone is too close to the stars or to the
+    // zone inside it, or a moon too close to its planet or the moon inside it.
+    // The shortfall is how much farther out the object would have to be.
+    struct SpacingError {
+        enum Kind { STAR_GAP, ZONE_GAP, MOON_GAP };
+        Kind kind;
+        int object;
+        double shortfall;
+    };
 
 
 public:
     void Load(const DataNode &node);
     void Save(DataWriter &file) const;
+    // Get the hash of the data node this system is saved as. This is the same as
+    // the DataNode::Hash() of the node it was loaded from if nothing changed,
+    // as long as that file was last saved by the editor.
+    uint64_t Hash() const;
+    // Get the line of the map file this system was loaded from, or 0 if it
+    // was not loaded from a file.
+    int SourceLine() const;
 
     const QString &TrueName() const;
     bool HasDisplayName() const;
@@ -93,7 +134,12 @@ public:
     // object is in orbit around something else, this function returns 0.
     double OccupiedRadius(const StellarObject &object) const;
     double OccupiedRadius() const;
+    // Get the band occupied by each primary object, in order. These are only
+    // recomputed when the objects change.
+    const std::vector<Ring> &OccupiedRings() const;
     double StarRadius() const;
+    // Find every place where the objects break the spacing rules.
+    std::vector<SpacingError> SpacingErrors() const;
 
     bool HasRamscoopUniversal() const;
     double RamscoopAddend() const;
@@ -102,8 +148,11 @@ public:
     const std::vector<Asteroid> &Asteroids() const;
     std::vector<Minable> &Minables();
     const std::vector<Minable> &Minables() const;
+    const std::vector<Belt> &Belts() const;
 
     int Trade(const QString &commodity) const;
+    // Get the prices of all the commodities that are traded here.
+    const std::map<QString, int> &Trades() const;
 
     std::vector<PeriodicEvent> &Fleets();
     const std::vector<PeriodicEvent> &Fleets() const;
@@ -115,13 +164,18 @@ public:
     std::vector<RaidFleet> &RaidFleets();
     const std::vector<RaidFleet> &RaidFleets() const;
 
-    // Position the planets, etc.
+    // Position the planets, etc. This packs the orbits into a new propagator
+    // each time, so anything that animates a system should keep its own
+    // OrbitPropagator instead.
     void SetDay(double day);
+    // Move the objects to positions found elsewhere for the given day, e.g. by
+    // an OrbitPropagator. The positions are offsets from the system's center.
+    void SetPositions(double day, const float *x, const float *y);
 
     // Modify the system:
-    void Init(const QString &name, const QVector2D &position);
+    void Init(const QString &name, const QVector2D &position, Random &random);
     void SetTrueName(const QString &name);
-    void SetDisplayName(const QString &name);
+    void SetDisplayName(const std::optional<QString> &name);
     void SetPosition(const QVector2D &pos);
     void SetGovernment(const QString &gov);
     void ToggleHidden();
@@ -129,6 +183,7 @@ public:
     void ToggleInaccessible();
     void ToggleLink(System *other);
     void ChangeLink(const QString &from, const QString &to);
+    void AddLink(const QString &name);
     void SetJumpRange(double value);
     void SetHyperArrival(double value);
     void SetJumpArrival(double value);
@@ -144,15 +199,31 @@ public:
 
     // Editing the stellar objects and their locations:
     void Move(StellarObject *object, double dDistance, double dAngle = 0.);
-    void ChangeAsteroids();
-    void ChangeMinables();
-    void ChangeStar();
-    void ChangeSprite(StellarObject *object);
-    void AddPlanet();
-    void AddMoon(StellarObject *object, bool isStation = false);
-    void Randomize(bool allowHabitable, bool requireHabitable);
+    // These all take a generator for any random choices.
+    void ChangeAsteroids(Random &random);
+    void ChangeMinables(Random &random);
+    void ChangeStar(Random &random);
+    void ChangeSprite(StellarObject *object, Random &random);
+    void AddPlanet(Random &random);
+    void AddMoon(StellarObject *object, Random &random, bool isStation = false);
+    bool Randomize(bool allowHabitable, bool requireHabitable, Random &random);
+    // Generate new stellar objects that meet the given constraints, as closely
+    // as they can be met, without ever retrying. Return false if they could
+    // not all be met, e.g. if no star left room for a required habitable planet.
+    bool Randomize(const Constraints &constraints, Random &random);
     void Delete(StellarObject *object);
 
+    // Get or restore the orbits of all objects from the given index onward, or
+    // replace all the objects at once. These are used for undoing edits.
+    std::vector<Orbit> Orbits(int first) const;
+    void SetOrbits(int first, const std::vector<Orbit> &orbits);
+    void SetObjects(const std::vector<StellarObject> &newObjects, double newHabitable);
+    void SetAsteroids(const std::vector<Asteroid> &newAsteroids, const std::vector<Minable> &newMinables,
+        const std::vector<Belt> &newBelts);
+    // Get a number that changes whenever the stellar objects or their orbits
+    // do, so that anything derived from them can be cached.
+    unsigned Revision() const;
+
     void UpdateObjectPointers();
 
 
@@ -160,13 +231,24 @@ private:
     void LoadObject(const DataNode &node, int parent = -1);
     void SaveObject(DataWriter &file, const StellarObject &object) const;
     void Recompute(StellarObject &object, bool updateOffset = true);
+    // Give the system a new revision number after its objects change.
+    void Revise();
+    // Get the total mass of the stars, which every planet's period depends on.
+    double StarMass();
+    // Add a primary planet of the given kind beyond all the other objects,
+    // never closer to the star than the given distance, without using any
+    // of the given sprites. It may be given a station as its outermost moon.
+    enum PlanetKind { ANY_PLANET, HABITABLE_PLANET, GIANT_PLANET, NOT_GIANT };
+    void AddPlanet(Random &random, PlanetKind kind, const StellarObject::UsedSprites &excluded,
+        double minDistance = 0., bool withStation = false);
 
     // Get a list of all sprites that are in use already.
-    std::set<QString> Used() const;
+    StellarObject::UsedSprites Used() const;
 
 
 private:
     QString trueName;
+    int sourceLine = 0;
     std::optional<QString> displayName;
     QVector2D position;
     QString government;
@@ -188,6 +270,14 @@ private:
     std::vector<StellarObject> objects;
 
     double habitable;
+    unsigned revision = 0;
+    // The occupied rings, and the revision they were found for.
+    mutable std::vector<Ring> rings;
+    mutable unsigned ringRevision = 0;
+    // The total mass of the stars, or -1 if a star may have changed since it
+    // was last found. Generated planets and moons never have star sprites, so
+    // adding them does not change it.
+    double starMass = -1.;
 
     bool ramscoopUniversal = true;
     double ramscoopAddend = 0.;
@@ -16,14 +16,23 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Map.h"
 #include "pi.h"
 #include "PlanetView.h"
+#include "Random.h"
 #include "SpriteSet.h"
 #include "StellarObject.h"
 #include "System.h"
+#include "TimelineStrip.h"
 
+#include <QCheckBox>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
 #include <QPainter>
 #include <QPainterPath>
 #include <QPalette>
+#include <QMessageBox>
 #include <QMouseEvent>
+#include <QResizeEvent>
+#include <QSpinBox>
 #include <QTabWidget>
 #include <QVector2D>
 
@@ -32,18 +41,27 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 using namespace std;
 
+namespace {
+    // The most planets or giants that can be asked for.
+    const int MAX_PLANETS = 20;
+}
+
 
 
 SystemView::SystemView(Map &mapData, DetailView *detailView, QTabWidget *tabs, QWidget *parent) :
-    QWidget(parent), mapData(mapData), detailView(detailView), tabs(tabs)
+    QWidget(parent), mapData(mapData), detailView(detailView), tabs(tabs),
+    animation(this, SLOT(step())), profiler("System")
 {
     setAutoFillBackground(true);
     QPalette p = palette();
     p.setColor(backgroundRole(), QColor(0, 0, 0));
     setPalette(p);
 
-    connect(&timer, SIGNAL(timeout()), this, SLOT(step()));
-    timer.start(1000. / 60.);
+    timeline = new TimelineStrip(this);
+    connect(timeline, SIGNAL(DayChanged(double)), this, SLOT(SetDay(double)));
+    connect(timeline, SIGNAL(SpeedChanged(double)), this, SLOT(SetSpeed(double)));
+    connect(timeline, SIGNAL(PauseClicked()), this, SLOT(Pause()));
+    connect(timeline, SIGNAL(TrailsToggled(bool)), this, SLOT(ShowTrails(bool)));
 }
 
 
@@ -56,9 +74,11 @@ void SystemView::Select(System *system)
     this->system = system;
     asteroids.Set(system);
     if(system)
-        system->SetDay(timeStep);
+        UpdatePositions();
 
     selectedObject = nullptr;
+    animation.SetActive(IsMoving());
+    UpdateTimeline();
 }
 
 
@@ -93,14 +113,21 @@ QSize SystemView::sizeHint() const
 
 void SystemView::step()
 {
-    if(isPaused || (tabs && tabs->currentWidget() != this))
+    int steps = animation.Steps();
+    if(!steps || !system)
         return;
 
-    timeStep += .1;
-    asteroids.Step();
-    if(system)
-        system->SetDay(timeStep);
-    update();
+    // Only repaint where the moving objects were and where they are now. The
+    // planets' positions are found directly from the day, so playing faster
+    // just skips further ahead. The asteroids are only scenery, so they keep
+    // drifting at their normal rate.
+    QRect before = MovingBounds();
+    timeStep += .1 * speed * steps;
+    for(int i = 0; i < steps; ++i)
+        asteroids.Step();
+    UpdatePositions();
+    timeline->SetDay(timeStep);
+    update(before | MovingBounds());
 }
 
 
@@ -110,8 +137,13 @@ void SystemView::RandomizeInhabited()
     if(system)
     {
         selectedObject = nullptr;
-        system->Randomize(true, true);
-        DidChange();
+        Random random(Random::NewSeed());
+        BeginEdit();
+        bool isMet = system->Randomize(true, true, random);
+        EndEdit("Randomize inhabited", random.Seed());
+        if(!isMet)
+            QMessageBox::warning(this, "Randomize", "None of the stars that were tried left room for a habitable"
+                " planet, so the planet is outside the habitable zone. Randomize it again to try other stars.");
     }
 }
 
@@ -122,8 +154,10 @@ void SystemView::Randomize()
     if(system)
     {
         selectedObject = nullptr;
-        system->Randomize(true, false);
-        DidChange();
+        Random random(Random::NewSeed());
+        BeginEdit();
+        system->Randomize(true, false, random);
+        EndEdit("Randomize", random.Seed());
     }
 }
 
@@ -134,20 +168,87 @@ void SystemView::RandomizeUninhabited()
     if(system)
     {
         selectedObject = nullptr;
-        system->Randomize(false, false);
-        DidChange();
+        Random random(Random::NewSeed());
+        BeginEdit();
+        system->Randomize(false, false, random);
+        EndEdit("Randomize uninhabited", random.Seed());
     }
 }
 
 
 
+// Ask what the system must have, then randomize it.
+void SystemView::RandomizeConstrained()
+{
+    if(!system)
+        return;
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Randomize with constraints");
+    QFormLayout *layout = new QFormLayout(&dialog);
+
+    QCheckBox *inhabited = new QCheckBox("Allow inhabited objects", &dialog);
+    inhabited->setChecked(constraints.allowInhabited);
+    layout->addRow(inhabited);
+    QCheckBox *habitable = new QCheckBox("Require a habitable planet", &dialog);
+    habitable->setChecked(constraints.requireHabitable);
+    layout->addRow(habitable);
+    QCheckBox *station = new QCheckBox("Require a station", &dialog);
+    station->setChecked(constraints.requireStation);
+    layout->addRow(station);
+
+    // The lowest value of each count stands for any number.
+    QSpinBox *planets = new QSpinBox(&dialog);
+    planets->setRange(-1, MAX_PLANETS);
+    planets->setSpecialValueText("Any");
+    planets->setValue(constraints.planets);
+    layout->addRow("Planets:", planets);
+    QSpinBox *giants = new QSpinBox(&dialog);
+    giants->setRange(-1, MAX_PLANETS);
+    giants->setSpecialValueText("Any");
+    giants->setValue(constraints.giants);
+    layout->addRow("Gas giants:", giants);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, SIGNAL(accepted()), &dialog, SLOT(accept()));
+    connect(buttons, SIGNAL(rejected()), &dialog, SLOT(reject()));
+    layout->addRow(buttons);
+    if(dialog.exec() != QDialog::Accepted)
+        return;
+
+    constraints.allowInhabited = inhabited->isChecked();
+    constraints.requireHabitable = habitable->isChecked();
+    constraints.requireStation = station->isChecked();
+    constraints.planets = planets->value();
+    constraints.giants = giants->value();
+
+    Random random(Random::NewSeed());
+    selectedObject = nullptr;
+    BeginEdit();
+    bool isMet = system->Randomize(constraints, random);
+    EndEdit("Randomize", random.Seed());
+    if(!isMet)
+        QMessageBox::warning(this, "Randomize with constraints", "The new system does not meet all of the"
+            " constraints: either none of the stars that were tried left room for a habitable planet, or no"
+            " planets were allowed for the habitable planet or station to be. Randomize it again to try"
+            " other stars.");
+}
+
+
+
 void SystemView::ChangeAsteroids()
 {
     if(system)
     {
-        system->ChangeAsteroids();
+        Random random(Random::NewSeed());
+        vector<System::Asteroid> oldAsteroids = system->Asteroids();
+        vector<System::Minable> oldMinables = system->Minables();
+        vector<System::Belt> oldBelts = system->Belts();
+        system->ChangeAsteroids(random);
+        mapData.History().ReplaceAsteroids(*system, std::move(oldAsteroids), std::move(oldMinables),
+            std::move(oldBelts), "Change asteroids in", random.Seed());
         asteroids.Set(system);
-        DidChange();
+        DidChange(Map::DETAILS);
     }
 }
 
@@ -157,10 +258,16 @@ void SystemView::ChangeMinables()
 {
     if(system)
     {
-        system->ChangeMinables();
+        Random random(Random::NewSeed());
+        vector<System::Asteroid> oldAsteroids = system->Asteroids();
+        vector<System::Minable> oldMinables = system->Minables();
+        vector<System::Belt> oldBelts = system->Belts();
+        system->ChangeMinables(random);
+        mapData.History().ReplaceAsteroids(*system, std::move(oldAsteroids), std::move(oldMinables),
+            std::move(oldBelts), "Change minables in", random.Seed());
         asteroids.Set(system);
         detailView->UpdateMinables();
-        DidChange();
+        DidChange(Map::DETAILS);
     }
 }
 
@@ -170,9 +277,11 @@ void SystemView::ChangeStar()
 {
     if(system)
     {
-        system->ChangeStar();
+        Random random(Random::NewSeed());
+        BeginEdit();
+        system->ChangeStar(random);
         selectedObject = nullptr;
-        DidChange();
+        EndEdit("Change star of", random.Seed());
     }
 }
 
@@ -186,13 +295,17 @@ void SystemView::ChangePlanet()
 
     if(selectedObject && selectedObject->Parent() < 0 && !selectedObject->IsStation())
     {
-        system->ChangeSprite(selectedObject);
-        DidChange();
+        Random random(Random::NewSeed());
+        BeginEdit();
+        system->ChangeSprite(selectedObject, random);
+        EndEdit("Change planet in", random.Seed());
     }
     else if(!selectedObject)
     {
-        system->AddPlanet();
-        DidChange();
+        Random random(Random::NewSeed());
+        BeginEdit();
+        system->AddPlanet(random);
+        EndEdit("Add planet to", random.Seed());
     }
 }
 
@@ -206,15 +319,19 @@ void SystemView::ChangeMoon()
 
     if(selectedObject && selectedObject->Parent() >= 0 && !selectedObject->IsStation())
     {
-        system->ChangeSprite(selectedObject);
-        DidChange();
+        Random random(Random::NewSeed());
+        BeginEdit();
+        system->ChangeSprite(selectedObject, random);
+        EndEdit("Change moon in", random.Seed());
     }
     else if(selectedObject && selectedObject->Parent() < 0)
     {
         int index = selectedObject - &system->Objects().front();
-        system->AddMoon(selectedObject);
+        Random random(Random::NewSeed());
+        BeginEdit();
+        system->AddMoon(selectedObject, random);
         selectedObject = &system->Objects()[index];
-        DidChange();
+        EndEdit("Add moon to", random.Seed());
     }
 }
 
@@ -228,15 +345,19 @@ void SystemView::ChangeStation()
 
     if(selectedObject && selectedObject->IsStation())
     {
-        system->ChangeSprite(selectedObject);
-        DidChange();
+        Random random(Random::NewSeed());
+        BeginEdit();
+        system->ChangeSprite(selectedObject, random);
+        EndEdit("Change station in", random.Seed());
     }
     else if(selectedObject && selectedObject->Parent() < 0)
     {
         int index = selectedObject - &system->Objects().front();
-        system->AddMoon(selectedObject, true);
+        Random random(Random::NewSeed());
+        BeginEdit();
+        system->AddMoon(selectedObject, random, true);
         selectedObject = &system->Objects()[index];
-        DidChange();
+        EndEdit("Add station to", random.Seed());
     }
 }
 
@@ -246,9 +367,10 @@ void SystemView::DeleteObject()
 {
     if(selectedObject)
     {
+        BeginEdit();
         system->Delete(selectedObject);
         selectedObject = nullptr;
-        DidChange();
+        EndEdit("Delete object from");
     }
 }
 
@@ -256,7 +378,36 @@ void SystemView::DeleteObject()
 
 void SystemView::Pause()
 {
-    isPaused = !isPaused;
+    animation.SetPaused(!animation.IsPaused());
+    timeline->SetPaused(animation.IsPaused());
+}
+
+
+
+// Jump straight to the given day.
+void SystemView::SetDay(double day)
+{
+    timeStep = day;
+    if(system)
+    {
+        UpdatePositions();
+        update();
+    }
+}
+
+
+
+void SystemView::SetSpeed(double speed)
+{
+    this->speed = speed;
+}
+
+
+
+void SystemView::ShowTrails(bool show)
+{
+    showTrails = show;
+    update();
 }
 
 
@@ -264,8 +415,10 @@ void SystemView::Pause()
 // Select a StellarObject and/or set the dragging position.
 void SystemView::mousePressEvent(QMouseEvent *event)
 {
-    // Reset the dragging target.
+    // Reset the dragging target, and start a new edit rather than continuing
+    // the last drag.
     dragObject = nullptr;
+    mapData.History().Seal();
 
     // Right- and middle-clicking deselects.
     if(event->button() != Qt::LeftButton)
@@ -345,12 +498,16 @@ void SystemView::mouseMoveEvent(QMouseEvent *event)
         double oldRadius = oldPosition.length();
         double newRadius = newPosition.length();
 
+        // Moving an object can also move the objects after it, so all of their
+        // orbits are recorded. The whole drag is merged into one edit.
+        int index = dragObject - &system->Objects().front();
+        vector<System::Orbit> before = system->Orbits(index);
         system->Move(dragObject, newRadius - oldRadius, (newAngle - oldAngle) * TO_DEG);
-        system->SetDay(timeStep);
-        mapData.SetChanged();
+        mapData.History().MoveObject(*system, index, before, true);
+        UpdatePositions();
+        mapData.SetChanged(true, Map::POSITIONS);
     }
-    if(isPaused)
-        update();
+    update();
 }
 
 
@@ -369,8 +526,16 @@ void SystemView::wheelEvent(QWheelEvent *event)
     // We want: point = origin * scale + offset + center.
     offset = point - origin * scale - center;
 
-    if(isPaused)
-        update();
+    update();
+}
+
+
+
+// Keep the timeline along the bottom of the view.
+void SystemView::resizeEvent(QResizeEvent */*event*/)
+{
+    int stripHeight = timeline->sizeHint().height();
+    timeline->setGeometry(0, height() - stripHeight, width(), stripHeight);
 }
 
 
@@ -380,6 +545,8 @@ void SystemView::paintEvent(QPaintEvent */*event*/)
     if(!system)
         return;
 
+    profiler.Begin();
+
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing, true);
     painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
@@ -389,24 +556,24 @@ void SystemView::paintEvent(QPaintEvent */*event*/)
     painter.scale(scale, scale);
 
     // Draw faint circles showing the region occupied by each planet as it orbits.
+    // Each one is a circle along the planet's orbit, stroked as wide as the
+    // region, so the rings are found once per edit rather than every frame.
+    QColor occupiedColor(20, 20, 20);
     painter.setPen(Qt::NoPen);
-    QBrush occupiedBrush(QColor(20, 20, 20));
-    painter.setBrush(occupiedBrush);
+    painter.setBrush(occupiedColor);
     double starRadius = system->StarRadius();
     painter.drawEllipse(QPointF(), starRadius, starRadius);
-    for(const StellarObject &object : system->Objects())
+    painter.setBrush(Qt::NoBrush);
+    QPen occupiedPen(occupiedColor);
+    occupiedPen.setCapStyle(Qt::FlatCap);
+    for(const System::Ring &ring : system->OccupiedRings())
     {
-        double radius = system->OccupiedRadius(object);
-        if(!radius)
+        if(!ring.width)
             continue;
 
-        QPainterPath outside;
-        outside.addEllipse(QPointF(), object.Distance() + radius, object.Distance() + radius);
-        QPainterPath inside;
-        outside.addEllipse(QPointF(), object.Distance() - radius, object.Distance() - radius);
-        QPainterPath ring = outside.subtracted(inside);
-
-        painter.drawPath(ring);
+        occupiedPen.setWidthF(ring.width);
+        painter.setPen(occupiedPen);
+        painter.drawEllipse(QPointF(), ring.radius, ring.radius);
     }
 
     // Draw circles indicating the center and edges of the habitable zone.
@@ -431,6 +598,25 @@ void SystemView::paintEvent(QPaintEvent */*event*/)
         painter.drawEllipse(QPointF(), 2. * radius, 2. * radius);
     }
 
+    // Draw the path each object follows around its parent.
+    if(showTrails)
+    {
+        UpdateTrails();
+        QPen trailPen(QColor(90, 90, 120));
+        trailPen.setCosmetic(true);
+        painter.setPen(trailPen);
+        painter.setBrush(Qt::NoBrush);
+        for(const auto &it : trails)
+        {
+            QPointF center;
+            if(it.first >= 0)
+                center = system->Objects()[it.first].Position().toPointF();
+            painter.translate(center);
+            painter.drawPath(it.second);
+            painter.translate(-center);
+        }
+    }
+
     // Draw lines linking objects to their parents.
     QBrush brush(QColor(128, 128, 128));
     painter.setBrush(brush);
@@ -462,16 +648,29 @@ void SystemView::paintEvent(QPaintEvent */*event*/)
         painter.drawPixmap(QPointF(-.5 * sprite.width(), -.5 * sprite.height()), sprite);
         painter.rotate(angle);
         painter.translate(-pos.toPointF());
+        profiler.Count(PaintProfiler::SPRITES);
         if(!object.GetPlanet().isEmpty())
         {
             double radius = object.Radius() + 5.;
             painter.drawEllipse(pos.toPointF(), radius, radius);
         }
     }
+    // Circle any objects that break the spacing rules.
+    QPen errorPen(QColor(255, 0, 0));
+    errorPen.setWidthF(2.5);
+    errorPen.setStyle(Qt::DashLine);
+    painter.setPen(errorPen);
+    UpdateSpacingErrors();
+    for(const System::SpacingError &error : spacingErrors)
+    {
+        const StellarObject &object = system->Objects()[error.object];
+        double radius = object.Radius() + 10.;
+        painter.drawEllipse(object.Position().toPointF(), radius, radius);
+    }
     // Get the bounding box of the paint region after scaling and offset.
     QVector2D half(.5 * width() / scale, .5 * height() / scale);
     QRectF bounds((offset / -scale - half).toPointF(), (offset / -scale + half).toPointF());
-    asteroids.Draw(painter, bounds);
+    profiler.Count(PaintProfiler::SPRITES, asteroids.Draw(painter, bounds));
 
     if(selectedObject)
     {
@@ -482,6 +681,9 @@ void SystemView::paintEvent(QPaintEvent */*event*/)
         double radius = selectedObject->Radius() + 10.;
         painter.drawEllipse(selectedObject->Position().toPointF(), radius, radius);
     }
+
+    profiler.End();
+    profiler.Draw(painter);
 }
 
 
@@ -497,10 +699,154 @@ QVector2D SystemView::MapPoint(QPoint pos) const
 
 
 
-// If a method did something, this updates the map, date, and draw window.
-void SystemView::DidChange()
+// If a method did something, this updates the map, date, and draw window. The
+// given parts of the map are the ones it changed.
+void SystemView::DidChange(unsigned parts)
 {
-    system->SetDay(timeStep);
-    mapData.SetChanged();
+    UpdatePositions();
+    mapData.SetChanged(true, parts);
+    animation.SetActive(IsMoving());
+    UpdateTimeline();
     update();
 }
+
+
+
+bool SystemView::IsMoving() const
+{
+    if(!system)
+        return false;
+    if(!asteroids.IsEmpty())
+        return true;
+    for(const StellarObject &object : system->Objects())
+        if(object.Period())
+            return true;
+    return false;
+}
+
+
+
+// Get the region of the widget that anything moving is drawn in, including
+// the lines to each object's parent and the rings around it. Asteroids cover
+// the whole view.
+QRect SystemView::MovingBounds() const
+{
+    if(!system || !asteroids.IsEmpty() || PaintProfiler::IsEnabled())
+        return rect();
+
+    QRectF bounds;
+    for(const StellarObject &object : system->Objects())
+    {
+        if(!object.Period() && object.Parent() < 0)
+            continue;
+
+        // Sprites are rotated as they orbit, so allow for their diagonal.
+        QPixmap sprite = SpriteSet::Get(object.Sprite());
+        QPointF pos = object.Position().toPointF();
+        double radius = max(.5 * hypot(sprite.width(), sprite.height()), object.Radius() + 10.);
+        bounds |= QRectF(pos - QPointF(radius, radius), pos + QPointF(radius, radius));
+
+        QPointF parent;
+        if(object.Parent() >= 0)
+            parent = system->Objects()[object.Parent()].Position().toPointF();
+        bounds |= QRectF(pos, parent).normalized();
+
+        // A moon's trail moves along with its parent.
+        if(showTrails && object.Parent() >= 0)
+        {
+            double distance = object.Distance();
+            bounds |= QRectF(parent - QPointF(distance, distance), parent + QPointF(distance, distance));
+        }
+    }
+    if(bounds.isEmpty())
+        return QRect();
+
+    // point = origin * scale + offset + center, plus room for the pen widths.
+    QPointF shift = (offset + QVector2D(.5 * width(), .5 * height())).toPointF();
+    QRectF view(bounds.topLeft() * scale + shift, bounds.bottomRight() * scale + shift);
+    return view.toAlignedRect().adjusted(-3, -3, 3, 3) & rect();
+}
+
+
+
+// Remember the system's objects before an edit that may replace any of them,
+// so that the edit can be undone.
+void SystemView::BeginEdit()
+{
+    editObjects = system->Objects();
+    editHabitable = system->HabitableZone();
+}
+
+
+
+// Record the edit, described as the given text followed by the system's name
+// (and the seed, if it was a random one).
+void SystemView::EndEdit(const QString &description, uint64_t seed)
+{
+    mapData.History().ReplaceObjects(*system, std::move(editObjects), editHabitable, description, seed);
+    editObjects.clear();
+    DidChange(Map::OBJECTS);
+}
+
+
+
+// Fit the timeline's slider to the system's slowest orbit.
+void SystemView::UpdateTimeline()
+{
+    double longest = 0.;
+    if(system)
+        for(const StellarObject &object : system->Objects())
+            longest = max(longest, fabs(object.Period()));
+    timeline->SetSpan(longest);
+    timeline->SetDay(timeStep);
+}
+
+
+
+// Rebuild the orbit trails if the system has changed since they were made.
+// Each orbit is a circle around its parent, so the trails of all the objects
+// with the same parent go in one path, which is drawn wherever that parent is.
+void SystemView::UpdateTrails()
+{
+    if(trailSystem == system && trailRevision == system->Revision())
+        return;
+
+    trailSystem = system;
+    trailRevision = system->Revision();
+    trails.clear();
+    for(const StellarObject &object : system->Objects())
+        if(object.Period() && object.Distance())
+            trails[object.Parent()].addEllipse(QPointF(), object.Distance(), object.Distance());
+}
+
+
+
+// Find the objects that break the spacing rules again, if the system has
+// changed since they were found.
+void SystemView::UpdateSpacingErrors()
+{
+    if(spacingSystem == system && spacingRevision == system->Revision())
+        return;
+
+    spacingSystem = system;
+    spacingRevision = system->Revision();
+    spacingErrors = system->SpacingErrors();
+}
+
+
+
+// Move the system's objects to where they are on the current day. The orbits
+// are only packed into the propagator's arrays again if the system or its
+// objects have changed, so each frame of the animation allocates nothing.
+void SystemView::UpdatePositions()
+{
+    if(orbitSystem != system || orbitRevision != system->Revision())
+    {
+        orbitSystem = system;
+        orbitRevision = system->Revision();
+        orbits.Clear();
+        orbits.Add(*system);
+    }
+    orbits.Propagate(timeStep);
+    orbits.Apply(*system, 0);
+}
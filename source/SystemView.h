@@ -13,19 +13,28 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef SYSTEMVIEW_H
 #define SYSTEMVIEW_H
 
+#include "AnimationScheduler.h"
 #include "AsteroidField.h"
+#include "OrbitPropagator.h"
+#include "PaintProfiler.h"
+#include "StellarObject.h"
+#include "System.h"
 
 #include <QWidget>
 
 #include <QElapsedTimer>
+#include <QPainterPath>
+#include <QRect>
 #include <QVector2D>
-#include <QTimer>
+
+#include <cstdint>
+#include <map>
+#include <vector>
 
 class DetailView;
 class Map;
 class PlanetView;
-class StellarObject;
-class System;
+class TimelineStrip;
 
 class QTabWidget;
 
@@ -52,6 +61,8 @@ public slots:
     void RandomizeInhabited();
     void Randomize();
     void RandomizeUninhabited();
+    // Ask what the system must have, then randomize it.
+    void RandomizeConstrained();
     void ChangeAsteroids();
     void ChangeMinables();
     void ChangeStar();
@@ -60,19 +71,41 @@ public slots:
     void ChangeStation();
     void DeleteObject();
     void Pause();
+    void SetDay(double day);
+    void SetSpeed(double speed);
+    void ShowTrails(bool show);
 
 protected:
     virtual void mousePressEvent(QMouseEvent *event) override;
     virtual void mouseDoubleClickEvent(QMouseEvent *event) override;
     virtual void mouseMoveEvent(QMouseEvent *event) override;
     virtual void wheelEvent(QWheelEvent *event) override;
+    virtual void resizeEvent(QResizeEvent *event) override;
 
     virtual void paintEvent(QPaintEvent *event) override;
 
 
 private:
     QVector2D MapPoint(QPoint pos) const;
-    void DidChange();
+    // Update everything after an edit that changed the given parts of the map.
+    void DidChange(unsigned parts);
+    // Check if anything in the system moves, and get the region of the widget
+    // covered by everything that does.
+    bool IsMoving() const;
+    QRect MovingBounds() const;
+    // Wrap an edit that may replace any of the system's objects, so that it
+    // can be undone. A random edit also records the seed it was made with.
+    void BeginEdit();
+    void EndEdit(const QString &description, uint64_t seed = 0);
+    // Fit the timeline's slider to the system's slowest orbit.
+    void UpdateTimeline();
+    // Rebuild the orbit trails if the system has changed since they were made.
+    void UpdateTrails();
+    // Find the objects that break the spacing rules again, if the system has
+    // changed since they were found.
+    void UpdateSpacingErrors();
+    // Move the system's objects to where they are on the current day.
+    void UpdatePositions();
 
 
 private:
@@ -84,15 +117,40 @@ private:
     // The current system being accessed and drawn.
     System *system = nullptr;
     StellarObject *selectedObject = nullptr;
+    // The objects from before the edit in progress.
+    std::vector<StellarObject> editObjects;
+    double editHabitable = 0.;
+    // The constraints that were last asked for.
+    System::Constraints constraints;
 
     // Center and scale of the view:
     QVector2D offset;
     double scale = 1.;
 
     // Time:
-    QTimer timer;
+    AnimationScheduler animation;
     double timeStep = 1000.;
-    bool isPaused = false;
+    // How many times faster than normal time passes.
+    double speed = 1.;
+    TimelineStrip *timeline;
+
+    // Orbit trails, as one path for all the orbits around each parent object
+    // (or -1 for the star), relative to that parent. They are rebuilt only
+    // when the system is changed.
+    bool showTrails = false;
+    std::map<int, QPainterPath> trails;
+    const System *trailSystem = nullptr;
+    unsigned trailRevision = 0;
+    // The objects that break the spacing rules, which only depends on the
+    // orbits and sprites, not on the day.
+    std::vector<System::SpacingError> spacingErrors;
+    const System *spacingSystem = nullptr;
+    unsigned spacingRevision = 0;
+    // The orbits of the system's objects, which are only packed into arrays
+    // again when the system is changed.
+    OrbitPropagator orbits;
+    const System *orbitSystem = nullptr;
+    unsigned orbitRevision = 0;
 
     // Dragging:
     QVector2D clickOff;
@@ -100,6 +158,8 @@ private:
     QElapsedTimer dragTime;
 
     AsteroidField asteroids;
+
+    PaintProfiler profiler;
 };
 
 #endif // SYSTEMVIEW_H
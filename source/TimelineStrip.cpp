@@ -0,0 +1,144 @@
+/* TimelineStrip.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "TimelineStrip.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QSlider>
+
+#include <cmath>
+
+using namespace std;
+
+namespace {
+    // Each speed is ten times the one before, up to 10,000x.
+    const int SPEEDS = 5;
+    // The slider has this many positions across its span.
+    const int SLIDER_STEPS = 1000;
+    const double MAX_DAY = 1e9;
+}
+
+
+
+TimelineStrip::TimelineStrip(QWidget *parent) :
+    QWidget(parent)
+{
+    setAutoFillBackground(true);
+
+    QHBoxLayout *layout = new QHBoxLayout(this);
+    layout->setContentsMargins(4, 2, 4, 2);
+
+    play = new QPushButton("Pause", this);
+    connect(play, SIGNAL(clicked()), this, SIGNAL(PauseClicked()));
+    layout->addWidget(play);
+
+    speed = new QComboBox(this);
+    for(int i = 0, value = 1; i < SPEEDS; ++i, value *= 10)
+        speed->addItem(QString::number(value) + "x");
+    connect(speed, SIGNAL(currentIndexChanged(int)), this, SLOT(SpeedSelected(int)));
+    layout->addWidget(speed);
+
+    slider = new QSlider(Qt::Horizontal, this);
+    slider->setRange(0, SLIDER_STEPS);
+    connect(slider, SIGNAL(valueChanged(int)), this, SLOT(SliderChanged(int)));
+    layout->addWidget(slider, 1);
+
+    dayBox = new QDoubleSpinBox(this);
+    dayBox->setRange(-MAX_DAY, MAX_DAY);
+    dayBox->setDecimals(1);
+    dayBox->setSuffix(" days");
+    connect(dayBox, SIGNAL(editingFinished()), this, SLOT(DayEdited()));
+    layout->addWidget(dayBox);
+
+    trails = new QCheckBox("Trails", this);
+    connect(trails, SIGNAL(toggled(bool)), this, SIGNAL(TrailsToggled(bool)));
+    layout->addWidget(trails);
+}
+
+
+
+// Show the given day, without signaling that it changed.
+void TimelineStrip::SetDay(double day)
+{
+    this->day = day;
+    UpdateSlider();
+
+    // Don't overwrite a day that the user is in the middle of typing.
+    if(!dayBox->hasFocus())
+    {
+        dayBox->blockSignals(true);
+        dayBox->setValue(day);
+        dayBox->blockSignals(false);
+    }
+}
+
+
+
+// Set how many days the slider spans.
+void TimelineStrip::SetSpan(double days)
+{
+    if(days <= 0. || days == span)
+        return;
+
+    span = days;
+    start = floor(day / span) * span;
+    UpdateSlider();
+}
+
+
+
+void TimelineStrip::SetPaused(bool isPaused)
+{
+    play->setText(isPaused ? "Play" : "Pause");
+}
+
+
+
+void TimelineStrip::SliderChanged(int value)
+{
+    day = start + value * span / SLIDER_STEPS;
+    SetDay(day);
+    emit DayChanged(day);
+}
+
+
+
+void TimelineStrip::DayEdited()
+{
+    day = dayBox->value();
+    UpdateSlider();
+    emit DayChanged(day);
+}
+
+
+
+void TimelineStrip::SpeedSelected(int index)
+{
+    emit SpeedChanged(pow(10., index));
+}
+
+
+
+// Move the slider to the current day, within the span that contains it.
+void TimelineStrip::UpdateSlider()
+{
+    if(day < start || day > start + span)
+        start = floor(day / span) * span;
+
+    slider->blockSignals(true);
+    slider->setValue(lround((day - start) / span * SLIDER_STEPS));
+    slider->blockSignals(false);
+}
@@ -0,0 +1,74 @@
+/* TimelineStrip.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef TIMELINESTRIP_H
+#define TIMELINESTRIP_H
+
+#include <QWidget>
+
+class QCheckBox;
+class QComboBox;
+class QDoubleSpinBox;
+class QPushButton;
+class QSlider;
+
+
+
+// Strip of controls for the system view's clock: a play / pause button, the
+// playback speed, a slider for scrubbing through one stretch of time (as long
+// as the system's slowest orbit), a box for typing in any day directly, and a
+// toggle for the orbit trails. The strip only reports what the user does; the
+// view decides what day it is, and tells the strip.
+class TimelineStrip : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit TimelineStrip(QWidget *parent = 0);
+
+    // Show the given day, without signaling that it changed.
+    void SetDay(double day);
+    // Set how many days the slider spans.
+    void SetSpan(double days);
+    void SetPaused(bool isPaused);
+
+signals:
+    void DayChanged(double day);
+    // The speed is a multiple of the normal playback rate.
+    void SpeedChanged(double speed);
+    void PauseClicked();
+    void TrailsToggled(bool show);
+
+private slots:
+    void SliderChanged(int value);
+    void DayEdited();
+    void SpeedSelected(int index);
+
+
+private:
+    // Move the slider to the current day, within the span that contains it.
+    void UpdateSlider();
+
+
+private:
+    QPushButton *play;
+    QComboBox *speed;
+    QSlider *slider;
+    QDoubleSpinBox *dayBox;
+    QCheckBox *trails;
+
+    double day = 0.;
+    // The slider covers this many days, starting on the given day.
+    double span = 1000.;
+    double start = 0.;
+};
+
+#endif // TIMELINESTRIP_H
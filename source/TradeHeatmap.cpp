@@ -0,0 +1,293 @@
+/* TradeHeatmap.cpp
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "TradeHeatmap.h"
+
+#include "GalaxyRenderer.h"
+#include "Map.h"
+#include "ParallelFor.h"
+#include "SpatialGrid.h"
+#include "System.h"
+
+#include <QColor>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+    // Size of each grid cell, in galaxy coordinates.
+    const double CELL_SIZE = 10.;
+    // Systems further than this from a cell have no effect on it.
+    const double RADIUS = 250.;
+    // Distance at which a system's weight has dropped by half (ignoring the
+    // falloff to zero at the edge of the radius).
+    const double SOFTEN = 20.;
+    // Cells where the total weight is below this are partly transparent, so
+    // the heatmap fades out away from the systems.
+    const double OPAQUE_WEIGHT = 1.;
+    const int MAX_ALPHA = 160;
+
+    // Inverse distance weight, smoothly falling off to zero at the radius.
+    double Weight(double distanceSquared)
+    {
+        if(distanceSquared >= RADIUS * RADIUS)
+            return 0.;
+        double falloff = 1. - distanceSquared / (RADIUS * RADIUS);
+        return falloff * falloff / (1. + distanceSquared / (SOFTEN * SOFTEN));
+    }
+}
+
+
+
+TradeHeatmap::TradeHeatmap(const Map &mapData)
+    : mapData(mapData)
+{
+}
+
+
+
+// Bring the heatmap up to date with the map's current prices for the given
+// commodity. Returns false if nothing needed to be recomputed.
+bool TradeHeatmap::Update(const QString &commodity)
+{
+    // Prices and positions can only change when the map is edited, so there is
+    // no need to look for changes on every frame.
+    if(commodity == this->commodity && mapData.Revision() == revision)
+        return false;
+    revision = mapData.Revision();
+
+    map<QString, Sample> newSamples;
+    for(const auto &it : mapData.Systems())
+    {
+        // Systems with no price for this commodity have no trade at all.
+        int price = it.second.Trade(commodity);
+        if(price)
+            newSamples[it.first] = {it.second.Position().toPointF(),
+                mapData.MapPrice(commodity, price)};
+    }
+
+    // If any system is now too close to the edge of the grid for all of its
+    // cells to fit, the grid must be resized.
+    bool isRebuild = (commodity != this->commodity || image.isNull());
+    QRectF inner = bounds.adjusted(RADIUS, RADIUS, -RADIUS, -RADIUS);
+    for(auto it = newSamples.begin(); it != newSamples.end() && !isRebuild; ++it)
+        isRebuild = !inner.contains(it->second.position);
+    if(isRebuild)
+    {
+        this->commodity = commodity;
+        Rebuild(newSamples);
+        return true;
+    }
+
+    // Find the systems that were added, removed, or changed, by walking both
+    // sets of samples (which are sorted by name) in step.
+    vector<pair<const Sample *, double>> changes;
+    auto oldIt = samples.begin();
+    auto newIt = newSamples.begin();
+    while(oldIt != samples.end() || newIt != newSamples.end())
+    {
+        if(newIt == newSamples.end() || (oldIt != samples.end() && oldIt->first < newIt->first))
+            changes.emplace_back(&(oldIt++)->second, -1.);
+        else if(oldIt == samples.end() || newIt->first < oldIt->first)
+            changes.emplace_back(&(newIt++)->second, 1.);
+        else
+        {
+            if(oldIt->second != newIt->second)
+            {
+                changes.emplace_back(&oldIt->second, -1.);
+                changes.emplace_back(&newIt->second, 1.);
+            }
+            ++oldIt;
+            ++newIt;
+        }
+    }
+    if(changes.empty())
+        return false;
+
+    // If much of the map changed, it is faster to start over.
+    if(changes.size() > samples.size() / 4 + 1)
+    {
+        Rebuild(newSamples);
+        return true;
+    }
+
+    QRect dirty;
+    for(const auto &change : changes)
+        Apply(*change.first, change.second, dirty);
+    samples.swap(newSamples);
+    Colorize(dirty);
+    return true;
+}
+
+
+
+void TradeHeatmap::Clear()
+{
+    commodity.clear();
+    samples.clear();
+    bounds = QRectF();
+    columns = 0;
+    rows = 0;
+    weights.clear();
+    values.clear();
+    image = QImage();
+}
+
+
+
+// The colored grid, and the region of the map (in galaxy coordinates) it
+// should be stretched to cover.
+const QImage &TradeHeatmap::Image() const
+{
+    return image;
+}
+
+
+
+const QRectF &TradeHeatmap::Bounds() const
+{
+    return bounds;
+}
+
+
+
+bool TradeHeatmap::Sample::operator!=(const Sample &other) const
+{
+    // QPointF's own comparison is fuzzy, but any change at all should count.
+    return position.x() != other.position.x() || position.y() != other.position.y()
+        || value != other.value;
+}
+
+
+
+// Recompute every cell of the grid from scratch, one row per work item.
+void TradeHeatmap::Rebuild(const map<QString, Sample> &newSamples)
+{
+    samples = newSamples;
+    if(samples.empty())
+    {
+        QString name = commodity;
+        Clear();
+        commodity = name;
+        return;
+    }
+
+    // Leave room around the systems for some growth, so that dragging a system
+    // near the edge does not immediately require resizing the grid.
+    bounds = QRectF();
+    vector<const Sample *> list;
+    for(const auto &it : samples)
+    {
+        list.push_back(&it.second);
+        bounds |= QRectF(it.second.position, QSizeF(CELL_SIZE, CELL_SIZE));
+    }
+    double margin = 2. * RADIUS;
+    bounds.adjust(-margin, -margin, margin, margin);
+    columns = ceil(bounds.width() / CELL_SIZE);
+    rows = ceil(bounds.height() / CELL_SIZE);
+    bounds.setSize(QSizeF(columns * CELL_SIZE, rows * CELL_SIZE));
+    weights.assign(columns * rows, 0.);
+    values.assign(columns * rows, 0.);
+    image = QImage(columns, rows, QImage::Format_ARGB32_Premultiplied);
+
+    SpatialGrid grid(RADIUS);
+    for(unsigned i = 0; i < list.size(); ++i)
+        grid.Add(list[i]->position, i);
+
+    ParallelFor(rows, [&](int y)
+    {
+        double centerY = bounds.top() + (y + .5) * CELL_SIZE;
+        vector<int> nearby = grid.Query(QRectF(bounds.left() - RADIUS, centerY - RADIUS,
+            bounds.width() + 2. * RADIUS, 2. * RADIUS));
+        double *weight = &weights[y * columns];
+        double *value = &values[y * columns];
+        for(int x = 0; x < columns; ++x)
+        {
+            double centerX = bounds.left() + (x + .5) * CELL_SIZE;
+            for(int i : nearby)
+            {
+                double dx = list[i]->position.x() - centerX;
+                double dy = list[i]->position.y() - centerY;
+                double w = Weight(dx * dx + dy * dy);
+                weight[x] += w;
+                value[x] += w * list[i]->value;
+            }
+        }
+    });
+    Colorize(QRect(0, 0, columns, rows));
+}
+
+
+
+// Add (or, with a negative sign, remove) one system's contribution to the cells
+// around it, and expand the dirty rectangle to include those cells.
+void TradeHeatmap::Apply(const Sample &sample, double sign, QRect &dirty)
+{
+    QRect cells = CellsNear(sample.position);
+    for(int y = cells.top(); y <= cells.bottom(); ++y)
+    {
+        double dy = sample.position.y() - (bounds.top() + (y + .5) * CELL_SIZE);
+        for(int x = cells.left(); x <= cells.right(); ++x)
+        {
+            double dx = sample.position.x() - (bounds.left() + (x + .5) * CELL_SIZE);
+            double w = sign * Weight(dx * dx + dy * dy);
+            weights[y * columns + x] += w;
+            values[y * columns + x] += w * sample.value;
+        }
+    }
+    dirty |= cells;
+}
+
+
+
+// Convert the given cells' sums into colors.
+void TradeHeatmap::Colorize(const QRect &cells)
+{
+    if(cells.isEmpty())
+        return;
+
+    uchar *bits = image.bits();
+    qsizetype stride = image.bytesPerLine();
+    ParallelFor(cells.height(), [&](int i)
+    {
+        int y = cells.top() + i;
+        QRgb *out = reinterpret_cast<QRgb *>(bits + y * stride);
+        for(int x = cells.left(); x <= cells.right(); ++x)
+        {
+            // Removing a system's weight may leave some rounding error behind
+            // in cells that no longer have any systems nearby.
+            double weight = weights[y * columns + x];
+            if(weight < 1e-9)
+            {
+                out[x] = 0;
+                continue;
+            }
+            QColor color = GalaxyRenderer::MapColor(values[y * columns + x] / weight * 2. - 1.);
+            int alpha = MAX_ALPHA * min(1., weight / OPAQUE_WEIGHT);
+            out[x] = qPremultiply(qRgba(color.red(), color.green(), color.blue(), alpha));
+        }
+    });
+}
+
+
+
+// Get the cells within the radius of the given point, clipped to the grid.
+QRect TradeHeatmap::CellsNear(const QPointF &point) const
+{
+    int left = max(0, static_cast<int>(floor((point.x() - RADIUS - bounds.left()) / CELL_SIZE)));
+    int top = max(0, static_cast<int>(floor((point.y() - RADIUS - bounds.top()) / CELL_SIZE)));
+    int right = min(columns - 1, static_cast<int>(floor((point.x() + RADIUS - bounds.left()) / CELL_SIZE)));
+    int bottom = min(rows - 1, static_cast<int>(floor((point.y() + RADIUS - bounds.top()) / CELL_SIZE)));
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
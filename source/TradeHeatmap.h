@@ -0,0 +1,88 @@
+/* TradeHeatmap.h
+Copyright (c) 2026 by the Endless Sky Editor contributors
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef TRADEHEATMAP_H_
+#define TRADEHEATMAP_H_
+
+#include <QImage>
+#include <QPointF>
+#include <QRect>
+#include <QRectF>
+#include <QString>
+
+#include <map>
+#include <vector>
+
+class Map;
+
+
+
+// Class for showing how the price of a commodity varies across the map. The
+// prices of all the systems near each point are blended, weighted by inverse
+// distance, into a coarse grid that covers the whole map. That grid is then
+// colored in the same way as the systems, to be drawn scaled up (and smoothed)
+// underneath them. Nothing is checked unless the map's revision has changed.
+// Each grid cell keeps a running sum of the weights and the weighted prices, so
+// if only a few systems change (e.g. one price is edited, or one system is
+// dragged) only the cells around them are recomputed.
+class TradeHeatmap {
+public:
+    explicit TradeHeatmap(const Map &mapData);
+
+    // Bring the heatmap up to date with the map's current prices for the given
+    // commodity. Returns false if nothing needed to be recomputed.
+    bool Update(const QString &commodity);
+    void Clear();
+
+    // The colored grid, and the region of the map (in galaxy coordinates) it
+    // should be stretched to cover.
+    const QImage &Image() const;
+    const QRectF &Bounds() const;
+
+
+private:
+    // A single system's contribution to the heatmap.
+    struct Sample {
+        QPointF position;
+        // The price, mapped to a value between 0 and 1.
+        double value;
+
+        bool operator!=(const Sample &other) const;
+    };
+
+    void Rebuild(const std::map<QString, Sample> &newSamples);
+    void Apply(const Sample &sample, double sign, QRect &dirty);
+    void Colorize(const QRect &cells);
+    QRect CellsNear(const QPointF &point) const;
+
+
+private:
+    const Map &mapData;
+
+    QString commodity;
+    // The map revision the samples were last brought up to date with.
+    unsigned revision = 0;
+    std::map<QString, Sample> samples;
+
+    // The grid of cells, with the running sums for each cell.
+    QRectF bounds;
+    int columns = 0;
+    int rows = 0;
+    std::vector<double> weights;
+    std::vector<double> values;
+
+    QImage image;
+};
+
+
+
+#endif
@@ -10,15 +10,22 @@ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
 PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 */
 
+#include "BatchMode.h"
+#include "EditHistory.h"
 #include "MainWindow.h"
 #include "Map.h"
+#include "PaintProfiler.h"
+#include "Random.h"
 #include "SpriteSet.h"
 
 #include <QApplication>
+#include <QCoreApplication>
 #include <QFileInfo>
 #include <QFileOpenEvent>
+#include <QGuiApplication>
 #include <QString>
 
+#include <algorithm>
 #include <iostream>
 
 using namespace std;
@@ -45,12 +52,24 @@ public:
 
 void PrintHelp();
 void PrintVersion();
+int RenderMap(int &argc, char *argv[], const QString &mapPath, const QString &imagePath,
+    double scale, const QString &commodity, const QString &government, bool heatmap);
+int CheckMap(int &argc, char *argv[], const QString &mapPath);
 
 
 
 int main(int argc, char *argv[])
 {
+    if(argc > 1 && BatchMode::IsCommand(argv[1]))
+        return BatchMode::Run(argc, argv);
+
     QString path;
+    QString renderPath;
+    double renderScale = 1.;
+    QString commodity;
+    QString government;
+    bool heatmap = false;
+    bool check = false;
     for(int i = 1; i < argc; ++i)
     {
         QString arg = argv[i];
@@ -59,6 +78,26 @@ int main(int argc, char *argv[])
             PrintVersion();
             return 0;
         }
+        else if(arg == "-p" || arg == "--profile")
+            PaintProfiler::SetEnabled(true);
+        else if(arg == "--profile-log" && i + 1 < argc)
+            PaintProfiler::SetLogFile(argv[++i]);
+        else if(arg == "--undo-memory" && i + 1 < argc)
+            EditHistory::SetBudget(max(0., QString(argv[++i]).toDouble()) * (1 << 20));
+        else if(arg == "--seed" && i + 1 < argc)
+            Random::SetBaseSeed(QString(argv[++i]).toULongLong());
+        else if(arg == "--render" && i + 1 < argc)
+            renderPath = argv[++i];
+        else if(arg == "--scale" && i + 1 < argc)
+            renderScale = QString(argv[++i]).toDouble();
+        else if(arg == "--commodity" && i + 1 < argc)
+            commodity = argv[++i];
+        else if(arg == "--government" && i + 1 < argc)
+            government = argv[++i];
+        else if(arg == "--heatmap")
+            heatmap = true;
+        else if(arg == "--check")
+            check = true;
         else if(arg[0] != '-')
             path = arg;
         else
@@ -82,6 +121,10 @@ int main(int argc, char *argv[])
 #if defined _WIN32
     path.replace('\\', '/');
 #endif
+    if(check)
+        return CheckMap(argc, argv, path);
+    if(!renderPath.isEmpty())
+        return RenderMap(argc, argv, path, renderPath, renderScale, commodity, government, heatmap);
 
     QApplication app(argc, argv);
     Map mapData;
@@ -102,9 +145,25 @@ void PrintHelp()
     cerr << "Command line options:" << endl;
     cerr << "    -h, --help: print this help message." << endl;
     cerr << "    -v, --version: print version information." << endl;
+    cerr << "    -p, --profile: show how long each view takes to paint." << endl;
+    cerr << "    --profile-log <file>: write the paint time of every frame to the given" << endl;
+    cerr << "        file, one line per frame. Use \"-\" for standard error." << endl;
+    cerr << "    --undo-memory <MiB>: memory to use for the undo history (default 64)." << endl;
+    cerr << "        Once it is full, the oldest edits can no longer be undone." << endl;
+    cerr << "    --seed <number>: make the random edits of this session the same as in any" << endl;
+    cerr << "        other session started with the same seed, and in the same order." << endl;
+    cerr << "    --render <image>: draw the galaxy map into the given image file, without" << endl;
+    cerr << "        opening a window, and then exit." << endl;
+    cerr << "    --scale <factor>: scale of the rendered image (default 1)." << endl;
+    cerr << "    --commodity <name>: color the rendered systems by this commodity's price." << endl;
+    cerr << "    --heatmap: also draw a heatmap of the rendered commodity's price." << endl;
+    cerr << "    --government <name>: highlight the rendered systems with this government." << endl;
+    cerr << "    --check: check the map for consistency problems, print each one as" << endl;
+    cerr << "        \"file:line: rule: message\", and then exit. The exit status is 1 if" << endl;
+    cerr << "        any problems were found." << endl;
     cerr << "    <path to map.txt>: load the given map file." << endl;
     cerr << "        Sprites are then loaded from ../images/ relative to the map file." << endl;
-    cerr << endl;
+    BatchMode::PrintHelp();
     cerr << "Report bugs to: mzahniser@gmail.com" << endl;
     cerr << "Home page: <https://endless-sky.github.io>" << endl;
     cerr << endl;
@@ -121,3 +180,43 @@ void PrintVersion()
     cerr << "There is NO WARRANTY, to the extent permitted by law." << endl;
     cerr << endl;
 }
+
+
+
+// Draw the whole galaxy map into an image file. This does not need a display,
+// so unless told otherwise Qt is set to use its offscreen platform.
+int RenderMap(int &argc, char *argv[], const QString &mapPath, const QString &imagePath,
+    double scale, const QString &commodity, const QString &government, bool heatmap)
+{
+    if(mapPath.isEmpty())
+    {
+        cerr << "No map file was given to render." << endl;
+        return BatchMode::USAGE;
+    }
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QGuiApplication app(argc, argv);
+    BatchMode::RenderOptions options;
+    options.scale = scale;
+    options.commodity = commodity;
+    options.government = government;
+    options.heatmap = heatmap;
+    return BatchMode::Render(mapPath, imagePath, options);
+}
+
+
+
+// Check the map for consistency problems, printing one line for each. This
+// does not need a display, so it can be run as part of an automated build.
+int CheckMap(int &argc, char *argv[], const QString &mapPath)
+{
+    if(mapPath.isEmpty())
+    {
+        cerr << "No map file was given to check." << endl;
+        return BatchMode::USAGE;
+    }
+
+    QCoreApplication app(argc, argv);
+    return BatchMode::Validate({mapPath});
+}